@@ -1,3 +1,12 @@
 g++ -Wall -std=c++17 -c tests/test.cpp -o obj/test.o -I"src" -I"dependencies\SFML-2.6.1\include" -DSFML_STATIC
 g++ -o bin/run obj/test.o -L"dependencies\SFML-2.6.1\lib" -lsfml-graphics-s -lsfml-window-s -lsfml-system-s -lwinmm -lopengl32 -lfreetype -lgdi32
 @REM -mwindows
+
+g++ -Wall -std=c++17 -O2 -c tests/benchmark.cpp -o obj/benchmark.o -I"src" -I"dependencies\SFML-2.6.1\include" -DSFML_STATIC
+g++ -o bin/benchmark obj/benchmark.o -L"dependencies\SFML-2.6.1\lib" -lsfml-graphics-s -lsfml-window-s -lsfml-system-s -lwinmm -lopengl32 -lfreetype -lgdi32
+
+g++ -Wall -std=c++17 -O2 -c tests/soup_search.cpp -o obj/soup_search.o -I"src" -I"dependencies\SFML-2.6.1\include" -DSFML_STATIC
+g++ -o bin/soup_search obj/soup_search.o -L"dependencies\SFML-2.6.1\lib" -lsfml-graphics-s -lsfml-window-s -lsfml-system-s -lwinmm -lopengl32 -lfreetype -lgdi32
+
+g++ -Wall -std=c++17 -O2 -c tests/slab_network.cpp -o obj/slab_network.o -I"src" -I"dependencies\SFML-2.6.1\include" -DSFML_STATIC
+g++ -o bin/slab_network obj/slab_network.o -L"dependencies\SFML-2.6.1\lib" -lsfml-network-s -lsfml-system-s -lws2_32 -lwinmm
@@ -0,0 +1,188 @@
+#ifndef LIFEGAME_ADAPTIVEENGINE_H
+#define LIFEGAME_ADAPTIVEENGINE_H
+
+#include <bitwise_engine.h>
+#include <sparse_engine.h>
+#include <step_engine.h>
+#include <tiled_engine.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Runs whichever of the bitwise, tiled and sparse engines is cheapest for the
+// board as it is now. Every `sample_every` generations it looks at the mean
+// population and changed-cell count of the window, predicts each engine's
+// cost per generation and moves the board over if another engine is cheaper
+// by more than the hysteresis margin. The cost of the engine that ran is
+// re-fitted from the measured generation time each window, so predictions
+// follow the machine rather than the defaults.
+template <int HEIGHT, int WIDTH>
+class AdaptiveEngine : public StepEngine<HEIGHT, WIDTH> {
+public:
+    using Field = typename StepEngine<HEIGHT, WIDTH>::Field;
+
+    enum Kind { BITWISE, TILED, SPARSE, KINDS };
+
+    struct Switch {
+        uint64_t generation;
+        Kind from;
+        Kind to;
+        double ns_before;      // mean generation time of the window before
+        double ns_after {-1};  // of the window after, once measured
+    };
+private:
+    static constexpr int64_t AREA = static_cast<int64_t>(HEIGHT) * WIDTH;
+    static constexpr int64_t TILE_CELLS = 64 * TiledEngine<HEIGHT, WIDTH>::TILE_ROWS;
+    static constexpr int64_t TILES = static_cast<int64_t>(TiledEngine<HEIGHT, WIDTH>::TILES_X) *
+                                     TiledEngine<HEIGHT, WIDTH>::TILES_Y;
+
+    BitwiseEngine<HEIGHT, WIDTH> bitwise;
+    TiledEngine<HEIGHT, WIDTH> tiled;
+    SparseEngine<HEIGHT, WIDTH> sparse;
+    StepEngine<HEIGHT, WIDTH>* engines[KINDS] {&bitwise, &tiled, &sparse};
+    Kind current {BITWISE};
+
+    int32_t sample_every {64};
+    double hysteresis {0.25};
+    bool log {true};
+    // Nanoseconds per unit of work: per cell of area, per cell of a stepped
+    // tile, per live cell. The tiled engine runs the bitwise kernel, so its
+    // cost is kept as a factor over the bitwise one until it is measured.
+    double cost[KINDS] {0.05, 1.1, 20.0};
+
+    double ns_per_unit(Kind kind) const {
+        return kind == TILED ? cost[TILED] * cost[BITWISE] : cost[kind];
+    }
+
+    uint64_t generation {0};
+    int32_t window_generations {0};
+    double window_ns {0};
+    int64_t window_population {0};
+    int64_t window_changed {0};
+    int64_t window_active_tiles {0};
+    std::vector<Switch> switches;
+    std::unique_ptr<Field> scratch {std::make_unique<Field>()};
+
+    double units(Kind kind, double population, double changed, double active_tiles) const {
+        switch (kind) {
+            case BITWISE:
+                return static_cast<double>(AREA);
+            case TILED:
+                if (active_tiles < 0) {
+                    // Changes cluster; guess one busy tile per 64 changed cells
+                    // plus its ring of neighbours.
+                    active_tiles = changed > 0 ? std::min<double>(TILES, 9.0 * (1 + changed / 64)) : 0;
+                }
+                return active_tiles * TILE_CELLS + TILES * 64.0;
+            default:
+                return population + 1;
+        }
+    }
+
+    void evaluate() {
+        double n = window_generations;
+        double population = window_population / n;
+        double changed = window_changed / n;
+        double active_tiles = current == TILED ? window_active_tiles / n : -1;
+        double measured = window_ns / n;
+
+        if (!switches.empty() && switches.back().ns_after < 0) {
+            Switch& last = switches.back();
+            last.ns_after = measured;
+            if (log) {
+                fprintf(stderr, "adaptive: %s -> %s at generation %llu: %.0f -> %.0f ns/gen\n",
+                        kind_name(last.from), kind_name(last.to),
+                        static_cast<unsigned long long>(last.generation), last.ns_before, last.ns_after);
+            }
+        }
+
+        double fitted = measured / units(current, population, changed, active_tiles);
+        if (current == TILED) {
+            fitted /= cost[BITWISE];
+        }
+        cost[current] = 0.5 * cost[current] + 0.5 * fitted;
+
+        Kind best = current;
+        double predicted_current = ns_per_unit(current) * units(current, population, changed, active_tiles);
+        double predicted_best = predicted_current;
+        for (int k = 0; k < KINDS; k++) {
+            double predicted = ns_per_unit(static_cast<Kind>(k)) * units(static_cast<Kind>(k), population, changed, -1);
+            if (k != current && predicted < predicted_best) {
+                best = static_cast<Kind>(k);
+                predicted_best = predicted;
+            }
+        }
+        if (best != current && predicted_best < (1 - hysteresis) * predicted_current) {
+            switch_to(best, measured);
+        }
+    }
+
+    void switch_to(Kind kind, double ns_before) {
+        engines[current]->store(*scratch);
+        engines[kind]->load(*scratch);
+        switches.push_back(Switch {generation, current, kind, ns_before});
+        if (log) {
+            fprintf(stderr, "adaptive: switching %s -> %s at generation %llu\n",
+                    kind_name(current), kind_name(kind), static_cast<unsigned long long>(generation));
+        }
+        current = kind;
+    }
+public:
+    static const char* kind_name(Kind kind) {
+        static const char* names[KINDS] = {"bitwise", "tiled", "sparse"};
+        return names[kind];
+    }
+
+    const char* name() const override { return "adaptive"; }
+
+    void set_hashing(bool val) override {
+        this->hashing = val;
+        for (StepEngine<HEIGHT, WIDTH>* engine : engines) {
+            engine->set_hashing(val);
+        }
+    }
+
+    void clear() override { engines[current]->clear(); }
+
+    int32_t get_id(int32_t x, int32_t y) const override { return engines[current]->get_id(x, y); }
+
+    void set_id(int32_t x, int32_t y, int32_t id) override { engines[current]->set_id(x, y, id); }
+
+    int64_t get_population() const override { return engines[current]->get_population(); }
+
+    void load(const Field& field) override { engines[current]->load(field); }
+
+    void store(Field& field) const override { engines[current]->store(field); }
+
+    void step(GenerationCounters& counters) override {
+        auto begin = std::chrono::steady_clock::now();
+        engines[current]->step(counters);
+        window_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        window_population += counters.population;
+        window_changed += counters.births + counters.deaths;
+        if (current == TILED) {
+            window_active_tiles += tiled.get_active_tiles();
+        }
+        generation++;
+        if (++window_generations >= sample_every) {
+            evaluate();
+            window_generations = 0;
+            window_ns = 0;
+            window_population = window_changed = window_active_tiles = 0;
+        }
+    }
+
+    Kind get_current() const                        { return current;         }
+    const std::vector<Switch>& get_switches() const { return switches;        }
+    int32_t get_sample_every() const                { return sample_every;    }
+    double  get_hysteresis() const                  { return hysteresis;      }
+
+    void set_sample_every(int32_t val)  { sample_every = std::max(1, val); }
+    void set_hysteresis(double val)     { hysteresis = val;               }
+    void set_log(bool val)              { log = val;                      }
+};
+
+#endif // LIFEGAME_ADAPTIVEENGINE_H
@@ -0,0 +1,340 @@
+#ifndef LIFEGAME_ARENA_H
+#define LIFEGAME_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// Process-wide allocator for board storage and history buffers. Memory comes
+// from the system in large regions, on huge pages where it can be had:
+// explicit huge pages first, then ordinary pages with transparent huge pages
+// requested. Blocks are handed out in power-of-two size classes from 64
+// bytes, so every block is cache-line aligned and padded to whole lines, and
+// freed blocks go on a free list of the freeing thread to be reused by its
+// next allocation of the class. Once buffers have been allocated, a stepping
+// loop that frees and reallocates them never reaches the system allocator.
+// Blocks over MAX_CLASS_BYTES get a mapping of their own, kept for reuse by
+// an allocation of the same size when freed.
+class Arena {
+public:
+    static constexpr size_t MIN_CLASS_BYTES = 64;
+    static constexpr size_t MAX_CLASS_BYTES = 1 << 20;
+    static constexpr int32_t CLASSES = 15; // 64 B to 1 MB
+    static constexpr size_t REGION_BYTES = 32 << 20;
+    static constexpr size_t HUGE_PAGE_BYTES = 2 << 20;
+    // Blocks a thread keeps per class before it hands half back.
+    static constexpr uint32_t THREAD_CACHE_BLOCKS = 64;
+
+    struct Stats {
+        uint64_t allocations {0};
+        uint64_t frees {0};
+        uint64_t bytes_in_use {0};   // as rounded up to the block sizes
+        uint64_t system_maps {0};    // calls that went to the system
+        uint64_t regions {0};
+        uint64_t huge_regions {0};   // regions on explicit huge pages
+    };
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+        size_t bytes; // large blocks only
+    };
+
+    struct ThreadCache {
+        FreeBlock* lists[CLASSES] {};
+        uint32_t counts[CLASSES] {};
+    };
+
+    // Owns the calling thread's cache; returns its blocks when the thread ends.
+    struct CacheOwner {
+        ThreadCache cache;
+        ~CacheOwner();
+    };
+
+    std::mutex lock;
+    FreeBlock* shared_lists[CLASSES] {};
+    FreeBlock* large_list {nullptr};
+    uint8_t* region_next {nullptr};
+    uint8_t* region_end {nullptr};
+
+    std::atomic<uint64_t> allocations {0}, frees {0}, bytes_in_use {0};
+    std::atomic<uint64_t> system_maps {0}, regions {0}, huge_regions {0};
+
+    static ThreadCache*& thread_cache_slot() {
+        static thread_local ThreadCache* cache = nullptr;
+        return cache;
+    }
+    static bool& thread_done() {
+        static thread_local bool done = false;
+        return done;
+    }
+
+    // The calling thread's cache, or null once it has been torn down.
+    static ThreadCache* thread_cache() {
+        ThreadCache*& cache = thread_cache_slot();
+        if (cache == nullptr && !thread_done()) {
+            static thread_local CacheOwner owner;
+            cache = &owner.cache;
+        }
+        return cache;
+    }
+
+    static int32_t class_of(size_t bytes) {
+        int32_t c = 0;
+        for (size_t size = MIN_CLASS_BYTES; size < bytes; size <<= 1) {
+            c++;
+        }
+        return c;
+    }
+
+    static size_t class_bytes(int32_t c) { return MIN_CLASS_BYTES << c; }
+
+    static size_t round_up(size_t bytes, size_t unit) { return (bytes + unit - 1) / unit * unit; }
+
+    // `bytes` of fresh zeroed memory from the system, huge pages if possible.
+    void* map(size_t bytes, bool& huge) {
+        system_maps.fetch_add(1, std::memory_order_relaxed);
+        huge = false;
+#ifdef _WIN32
+        void* memory = nullptr;
+        SIZE_T large = GetLargePageMinimum();
+        if (large != 0 && bytes % large == 0) {
+            memory = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            huge = memory != nullptr;
+        }
+        if (memory == nullptr) {
+            memory = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        }
+        return memory;
+#else
+        void* memory = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        if (bytes % HUGE_PAGE_BYTES == 0) {
+            memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            huge = memory != MAP_FAILED;
+        }
+#endif
+        if (memory == MAP_FAILED) {
+            memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if (memory != MAP_FAILED) {
+                madvise(memory, bytes, MADV_HUGEPAGE);
+            }
+#endif
+        }
+        return memory != MAP_FAILED ? memory : nullptr;
+#endif
+    }
+
+    // A block of class c carved from the current region; lock held.
+    void* carve(int32_t c) {
+        const size_t bytes = class_bytes(c);
+        if (region_next == nullptr || static_cast<size_t>(region_end - region_next) < bytes) {
+            bool huge;
+            uint8_t* region = static_cast<uint8_t*>(map(REGION_BYTES, huge));
+            if (region == nullptr) {
+                return nullptr;
+            }
+            regions.fetch_add(1, std::memory_order_relaxed);
+            if (huge) {
+                huge_regions.fetch_add(1, std::memory_order_relaxed);
+            }
+            region_next = region;
+            region_end = region + REGION_BYTES;
+        }
+        void* block = region_next;
+        region_next += bytes;
+        return block;
+    }
+
+    // Up to `count` blocks of class c from the shared list or the region,
+    // chained; lock held.
+    FreeBlock* refill(int32_t c, uint32_t count, uint32_t& got) {
+        FreeBlock* head = nullptr;
+        got = 0;
+        while (got < count && shared_lists[c] != nullptr) {
+            FreeBlock* block = shared_lists[c];
+            shared_lists[c] = block->next;
+            block->next = head;
+            head = block;
+            got++;
+        }
+        while (got < count) {
+            FreeBlock* block = static_cast<FreeBlock*>(carve(c));
+            if (block == nullptr) {
+                break;
+            }
+            block->next = head;
+            head = block;
+            got++;
+        }
+        return head;
+    }
+
+    void* allocate_large(size_t bytes) {
+        bytes = round_up(bytes, HUGE_PAGE_BYTES);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (FreeBlock** link = &large_list; *link != nullptr; link = &(*link)->next) {
+                if ((*link)->bytes == bytes) {
+                    FreeBlock* block = *link;
+                    *link = block->next;
+                    return block;
+                }
+            }
+        }
+        bool huge;
+        return map(bytes, huge);
+    }
+public:
+    // The process's arena. Never destroyed, so containers with static
+    // storage can still free into it at exit.
+    static Arena& global() {
+        static Arena* arena = new Arena();
+        return *arena;
+    }
+
+    void* allocate(size_t bytes) {
+        if (bytes == 0) {
+            bytes = 1;
+        }
+        void* block;
+        if (bytes > MAX_CLASS_BYTES) {
+            block = allocate_large(bytes);
+            bytes = round_up(bytes, HUGE_PAGE_BYTES);
+        } else {
+            const int32_t c = class_of(bytes);
+            bytes = class_bytes(c);
+            ThreadCache* cache = thread_cache();
+            if (cache != nullptr && cache->lists[c] == nullptr) {
+                // Blocks of 8 KB and under are fetched half a cache at a time.
+                std::lock_guard<std::mutex> guard(lock);
+                uint32_t got;
+                cache->lists[c] = refill(c, c < 8 ? THREAD_CACHE_BLOCKS / 2 : 1, got);
+                cache->counts[c] = got;
+            }
+            if (cache != nullptr) {
+                FreeBlock* head = cache->lists[c];
+                if (head != nullptr) {
+                    cache->lists[c] = head->next;
+                    cache->counts[c]--;
+                }
+                block = head;
+            } else {
+                std::lock_guard<std::mutex> guard(lock);
+                uint32_t got;
+                block = refill(c, 1, got);
+            }
+        }
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes_in_use.fetch_add(bytes, std::memory_order_relaxed);
+        return block;
+    }
+
+    // `bytes` must be what the block was allocated with.
+    void deallocate(void* pointer, size_t bytes) {
+        if (pointer == nullptr) {
+            return;
+        }
+        if (bytes == 0) {
+            bytes = 1;
+        }
+        FreeBlock* block = static_cast<FreeBlock*>(pointer);
+        if (bytes > MAX_CLASS_BYTES) {
+            bytes = round_up(bytes, HUGE_PAGE_BYTES);
+            block->bytes = bytes;
+            std::lock_guard<std::mutex> guard(lock);
+            block->next = large_list;
+            large_list = block;
+        } else {
+            const int32_t c = class_of(bytes);
+            bytes = class_bytes(c);
+            ThreadCache* cache = thread_cache();
+            if (cache != nullptr) {
+                block->next = cache->lists[c];
+                cache->lists[c] = block;
+                if (++cache->counts[c] > THREAD_CACHE_BLOCKS) {
+                    std::lock_guard<std::mutex> guard(lock);
+                    while (cache->counts[c] > THREAD_CACHE_BLOCKS / 2) {
+                        FreeBlock* spare = cache->lists[c];
+                        cache->lists[c] = spare->next;
+                        spare->next = shared_lists[c];
+                        shared_lists[c] = spare;
+                        cache->counts[c]--;
+                    }
+                }
+            } else {
+                std::lock_guard<std::mutex> guard(lock);
+                block->next = shared_lists[c];
+                shared_lists[c] = block;
+            }
+        }
+        frees.fetch_add(1, std::memory_order_relaxed);
+        bytes_in_use.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    Stats get_stats() const {
+        Stats stats;
+        stats.allocations = allocations.load(std::memory_order_relaxed);
+        stats.frees = frees.load(std::memory_order_relaxed);
+        stats.bytes_in_use = bytes_in_use.load(std::memory_order_relaxed);
+        stats.system_maps = system_maps.load(std::memory_order_relaxed);
+        stats.regions = regions.load(std::memory_order_relaxed);
+        stats.huge_regions = huge_regions.load(std::memory_order_relaxed);
+        return stats;
+    }
+};
+
+inline Arena::CacheOwner::~CacheOwner() {
+    Arena& arena = Arena::global();
+    {
+        std::lock_guard<std::mutex> guard(arena.lock);
+        for (int32_t c = 0; c < CLASSES; c++) {
+            while (cache.lists[c] != nullptr) {
+                FreeBlock* block = cache.lists[c];
+                cache.lists[c] = block->next;
+                block->next = arena.shared_lists[c];
+                arena.shared_lists[c] = block;
+            }
+        }
+    }
+    thread_cache_slot() = nullptr;
+    thread_done() = true;
+}
+
+// Standard allocator over Arena::global(), for containers of board storage
+// and history.
+template <class T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() = default;
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(Arena::global().allocate(n * sizeof(T))); }
+    void deallocate(T* pointer, size_t n) { Arena::global().deallocate(pointer, n * sizeof(T)); }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>&) const { return true; }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>&) const { return false; }
+};
+
+#endif // LIFEGAME_ARENA_H
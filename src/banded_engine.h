@@ -0,0 +1,213 @@
+#ifndef LIFEGAME_BANDEDENGINE_H
+#define LIFEGAME_BANDEDENGINE_H
+
+#include <bit_grid.h>
+#include <life_trace.h>
+#include <numa.h>
+#include <step_engine.h>
+#include <thread_pool.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Bit-packed engine that steps the board on a thread pool, each worker
+// always stepping the same band of rows; the calling thread only waits, so
+// its affinity is left alone. Workers are pinned to CPU sets and the boards
+// are allocated untouched, then zeroed band by band by the worker that owns
+// the band, so on a multi-socket machine every band's pages sit on the node
+// of the thread that steps it. Layout is BitGrid's, as two bare buffers.
+template <int HEIGHT, int WIDTH>
+class BandedEngine : public StepEngine<HEIGHT, WIDTH> {
+public:
+    static constexpr int32_t WORDS = BitGrid<HEIGHT, WIDTH>::WORDS;
+    static constexpr int32_t STRIDE = BitGrid<HEIGHT, WIDTH>::STRIDE;
+    static constexpr uint64_t TAIL_MASK = BitGrid<HEIGHT, WIDTH>::TAIL_MASK;
+    static constexpr size_t BOARD_WORDS = static_cast<size_t>(HEIGHT + 2) * STRIDE;
+private:
+    ThreadPool pool;
+    int32_t bands;
+    std::vector< std::vector<int> > cpu_sets;
+    std::vector<uint8_t> pinned;
+    // Deliberately not value-initialised: the owning threads touch them first.
+    std::unique_ptr<uint64_t[]> cells, next_cells;
+    std::vector<GenerationCounters> band_counters;
+
+    // Rows [x0, x1) of band b; the first and last bands also own the
+    // padding row next to them.
+    void band_rows(int32_t b, int32_t& x0, int32_t& x1) const {
+        x0 = static_cast<int32_t>(static_cast<int64_t>(HEIGHT) * b / bands);
+        x1 = static_cast<int32_t>(static_cast<int64_t>(HEIGHT) * (b + 1) / bands);
+    }
+
+    // Words of both boards that band b owns.
+    void band_words(int32_t b, size_t& begin, size_t& end) const {
+        int32_t x0, x1;
+        band_rows(b, x0, x1);
+        begin = b == 0 ? 0 : static_cast<size_t>(x0 + 1) * STRIDE;
+        end = b == bands - 1 ? BOARD_WORDS : static_cast<size_t>(x1 + 1) * STRIDE;
+    }
+
+    uint64_t* row(uint64_t* board, int32_t x) const { return board + static_cast<size_t>(x + 1) * STRIDE + 1; }
+    const uint64_t* row(const uint64_t* board, int32_t x) const {
+        return board + static_cast<size_t>(x + 1) * STRIDE + 1;
+    }
+
+    // Band of pool thread t, or -1 for the caller and spare workers.
+    int32_t band_of(size_t t) const {
+        return t >= 1 && static_cast<int32_t>(t) <= bands ? static_cast<int32_t>(t) - 1 : -1;
+    }
+
+    // Pins worker w (thread w + 1) to set w modulo the number of sets and
+    // records which took.
+    void pin_threads() {
+        pool.for_each_thread([&](size_t t) {
+            if (t >= 1) {
+                pinned[t - 1] = cpu_sets.empty() || pin_current_thread(cpu_sets[(t - 1) % cpu_sets.size()]);
+            }
+        });
+    }
+
+    // Every band's words of both boards written by the band's thread.
+    void first_touch() {
+        pool.for_each_thread([&](size_t t) {
+            int32_t b = band_of(t);
+            if (b >= 0) {
+                size_t begin, end;
+                band_words(b, begin, end);
+                std::memset(cells.get() + begin, 0, (end - begin) * sizeof(uint64_t));
+                std::memset(next_cells.get() + begin, 0, (end - begin) * sizeof(uint64_t));
+            }
+        });
+    }
+
+    template <bool HASH>
+    void step_band(int32_t b) {
+        int32_t x0, x1;
+        band_rows(b, x0, x1);
+        GenerationCounters counters;
+        life_step_rows<HASH>(row(cells.get(), 0), row(next_cells.get(), 0), STRIDE, WORDS, TAIL_MASK, x0, x1, 0,
+                             WORDS, counters);
+        band_counters[b] = counters;
+    }
+public:
+    // `threads` workers, 0 meaning one per hardware thread. Worker w runs on
+    // CPU w of the machine unless set_cpu_sets() says otherwise.
+    explicit BandedEngine(size_t threads = 0)
+        : pool((threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency())) + 1),
+          bands(static_cast<int32_t>(std::min<size_t>(pool.size() - 1, HEIGHT))),
+          pinned(pool.size() - 1, 0), cells(new uint64_t[BOARD_WORDS]), next_cells(new uint64_t[BOARD_WORDS]),
+          band_counters(bands) {
+        const size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t w = 0; w + 1 < pool.size(); w++) {
+            cpu_sets.push_back({ static_cast<int>(w % cpus) });
+        }
+        pin_threads();
+        first_touch();
+    }
+
+    const char* name() const override { return "banded"; }
+
+    // Re-pins the workers, worker w to sets[w % sets.size()]; an empty list
+    // leaves them where they are. The board moves with them: it is copied
+    // into fresh buffers first touched by the re-pinned threads.
+    void set_cpu_sets(const std::vector< std::vector<int> >& sets) {
+        cpu_sets = sets;
+        pin_threads();
+        std::unique_ptr<uint64_t[]> old(std::move(cells));
+        cells.reset(new uint64_t[BOARD_WORDS]);
+        next_cells.reset(new uint64_t[BOARD_WORDS]);
+        first_touch();
+        std::memcpy(cells.get(), old.get(), BOARD_WORDS * sizeof(uint64_t));
+    }
+
+    const std::vector< std::vector<int> >& get_cpu_sets() const { return cpu_sets; }
+
+    size_t get_threads() const { return pool.size() - 1; }
+    int32_t get_bands() const { return bands; }
+
+    // Whether the last pinning of worker w took.
+    bool is_pinned(size_t w) const { return pinned[w] != 0; }
+
+    // Where the pages of band b of both boards are.
+    NumaPlacement get_placement(int32_t b) const {
+        size_t begin, end;
+        band_words(b, begin, end);
+        NumaPlacement placement = numa_placement(cells.get() + begin, (end - begin) * sizeof(uint64_t));
+        placement.add(numa_placement(next_cells.get() + begin, (end - begin) * sizeof(uint64_t)));
+        return placement;
+    }
+
+    NumaPlacement get_placement() const {
+        NumaPlacement placement;
+        for (int32_t b = 0; b < bands; b++) {
+            placement.add(get_placement(b));
+        }
+        return placement;
+    }
+
+    void clear() override {
+        pool.for_each_thread([&](size_t t) {
+            int32_t b = band_of(t);
+            if (b >= 0) {
+                size_t begin, end;
+                band_words(b, begin, end);
+                std::memset(cells.get() + begin, 0, (end - begin) * sizeof(uint64_t));
+            }
+        });
+    }
+
+    int32_t get_id(int32_t x, int32_t y) const override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            return (row(cells.get(), x)[y >> 6] >> (y & 63)) & 1;
+        }
+        return -1;
+    }
+
+    void set_id(int32_t x, int32_t y, int32_t id) override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            uint64_t bit = 1ULL << (y & 63);
+            uint64_t& word = row(cells.get(), x)[y >> 6];
+            word = id != 0 ? word | bit : word & ~bit;
+        }
+    }
+
+    int64_t get_population() const override {
+        int64_t population = 0;
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            const uint64_t* r = row(cells.get(), x);
+            for (int32_t w = 0; w < WORDS; w++) {
+                population += __builtin_popcountll(r[w]);
+            }
+        }
+        return population;
+    }
+
+    void step(GenerationCounters& counters) override {
+        LIFE_TRACE_SCOPE("banded_step");
+        pool.for_each_thread([&](size_t t) {
+            int32_t b = band_of(t);
+            if (b >= 0) {
+                if (this->hashing) {
+                    step_band<true>(b);
+                } else {
+                    step_band<false>(b);
+                }
+            }
+        });
+        counters = GenerationCounters {};
+        for (const GenerationCounters& band : band_counters) {
+            counters.population += band.population;
+            counters.births += band.births;
+            counters.deaths += band.deaths;
+            counters.hash_delta ^= band.hash_delta;
+        }
+        std::swap(cells, next_cells);
+    }
+};
+
+#endif // LIFEGAME_BANDEDENGINE_H
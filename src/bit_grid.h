@@ -0,0 +1,159 @@
+#ifndef LIFEGAME_BITGRID_H
+#define LIFEGAME_BITGRID_H
+
+#include <arena.h>
+#include <life_stats.h>
+#include <zobrist.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Two-state board packed 64 cells to a word: column y of row x is bit y % 64
+// of word y / 64. Every row is framed by a zero word on each side and the
+// board by a zero row above and below, so kernels can read one cell past any
+// edge without bounds checks. Bits past WIDTH in the last word stay zero.
+// Storage comes from the arena.
+template <int HEIGHT, int WIDTH>
+class BitGrid {
+public:
+    static constexpr int32_t WORDS  = (WIDTH + 63) / 64;
+    static constexpr int32_t STRIDE = WORDS + 2;
+    static constexpr uint64_t TAIL_MASK = (WIDTH % 64 == 0) ? ~0ULL : ((1ULL << (WIDTH % 64)) - 1);
+private:
+    std::vector< uint64_t, ArenaAllocator<uint64_t> > words;
+public:
+    BitGrid() : words(static_cast<size_t>(HEIGHT + 2) * STRIDE, 0) {}
+
+    // Word 0 of row x, for -1 <= x <= HEIGHT; words -1 and WORDS are padding.
+    uint64_t* row(int32_t x) {
+        return words.data() + static_cast<size_t>(x + 1) * STRIDE + 1;
+    }
+    const uint64_t* row(int32_t x) const {
+        return words.data() + static_cast<size_t>(x + 1) * STRIDE + 1;
+    }
+
+    bool get(int32_t x, int32_t y) const {
+        return (row(x)[y >> 6] >> (y & 63)) & 1;
+    }
+
+    void set(int32_t x, int32_t y, bool alive) {
+        uint64_t bit = 1ULL << (y & 63);
+        if (alive) {
+            row(x)[y >> 6] |= bit;
+        } else {
+            row(x)[y >> 6] &= ~bit;
+        }
+    }
+
+    void clear() {
+        std::memset(words.data(), 0, words.size() * sizeof(uint64_t));
+    }
+
+    int64_t population() const {
+        int64_t count = 0;
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            const uint64_t* r = row(x);
+            for (int32_t w = 0; w < WORDS; w++) {
+                count += __builtin_popcountll(r[w]);
+            }
+        }
+        return count;
+    }
+
+    bool operator==(const BitGrid& other) const { return words == other.words; }
+    bool operator!=(const BitGrid& other) const { return words != other.words; }
+};
+
+// Bit-sliced neighbour count: each of the 64 bit lanes of the eight inputs is
+// one neighbour of the cell in the same lane. Sets the four bit planes of the
+// count (0 to 8), b0 being the ones.
+inline void life_lanes_count(uint64_t n0, uint64_t n1, uint64_t n2, uint64_t n3,
+                             uint64_t n4, uint64_t n5, uint64_t n6, uint64_t n7,
+                             uint64_t& b0, uint64_t& b1, uint64_t& b2, uint64_t& b3) {
+    // Full adders over three triples and a pair: (ones, twos) per group.
+    uint64_t s_a = n0 ^ n1, c_a = n0 & n1;
+    uint64_t ones_a = s_a ^ n2, twos_a = c_a | (s_a & n2);
+    uint64_t s_b = n3 ^ n4, c_b = n3 & n4;
+    uint64_t ones_b = s_b ^ n5, twos_b = c_b | (s_b & n5);
+    uint64_t ones_c = n6 ^ n7, twos_c = n6 & n7;
+
+    uint64_t s_ab = ones_a ^ ones_b, c_ab = ones_a & ones_b;
+    b0 = s_ab ^ ones_c;
+    uint64_t carry = c_ab | (s_ab & ones_c);
+
+    // twos_a + twos_b + twos_c + carry, each of weight 2.
+    uint64_t t1 = twos_a ^ twos_b, t1c = twos_a & twos_b;
+    uint64_t t2 = twos_c ^ carry,  t2c = twos_c & carry;
+    uint64_t c12 = t1 & t2;
+    b1 = t1 ^ t2;
+    b2 = t1c ^ t2c ^ c12;
+    b3 = (t1c & t2c) | (t1c & c12) | (t2c & c12);
+}
+
+// Next state of 64 independent Life (B3/S23) cells, one per bit lane, from
+// their eight neighbour words.
+inline uint64_t life_lanes_step(uint64_t n0, uint64_t n1, uint64_t n2, uint64_t n3,
+                                uint64_t n4, uint64_t n5, uint64_t n6, uint64_t n7, uint64_t center) {
+    uint64_t b0, b1, b2, b3;
+    life_lanes_count(n0, n1, n2, n3, n4, n5, n6, n7, b0, b1, b2, b3);
+    // 3 -> alive, 2 -> unchanged, anything else (0, 1, 4+) -> dead.
+    return b1 & ~(b2 | b3) & (b0 | center);
+}
+
+// Next state of 64 cells of Life (B3/S23) from the words of the rows above,
+// at and below them plus the words either side, in a handful of bitwise ops.
+inline uint64_t life_word_step(const uint64_t* above, const uint64_t* center, const uint64_t* below) {
+    // Neighbour at column y - 1 lands on bit y with a left shift.
+    uint64_t a_l = (above[0] << 1)  | (above[-1] >> 63);
+    uint64_t a_r = (above[0] >> 1)  | (above[1] << 63);
+    uint64_t c_l = (center[0] << 1) | (center[-1] >> 63);
+    uint64_t c_r = (center[0] >> 1) | (center[1] << 63);
+    uint64_t b_l = (below[0] << 1)  | (below[-1] >> 63);
+    uint64_t b_r = (below[0] >> 1)  | (below[1] << 63);
+    return life_lanes_step(a_l, above[0], a_r, b_l, below[0], b_r, c_l, c_r, center[0]);
+}
+
+// Steps rows [x_begin, x_end) and words [w_begin, w_end) of a padded
+// bit-packed board laid out like BitGrid: `cur` and `next` point at word 0 of
+// row 0 and rows are `stride` words apart. `words` and `tail_mask` describe
+// the last word of a row. Adds to the counters and returns whether any cell
+// changed.
+template <bool HASH = false>
+bool life_step_rows(const uint64_t* cur, uint64_t* next, int32_t stride, int32_t words, uint64_t tail_mask,
+                    int32_t x_begin, int32_t x_end, int32_t w_begin, int32_t w_end,
+                    GenerationCounters& counters) {
+    uint64_t changed = 0;
+    uint64_t hash_delta = 0;
+    int64_t population = 0, births = 0, deaths = 0;
+    for (int32_t x = x_begin; x < x_end; x++) {
+        const uint64_t* center = cur + static_cast<ptrdiff_t>(x) * stride;
+        const uint64_t* above  = center - stride;
+        const uint64_t* below  = center + stride;
+        uint64_t* out = next + static_cast<ptrdiff_t>(x) * stride;
+        for (int32_t w = w_begin; w < w_end; w++) {
+            uint64_t cell = center[w];
+            uint64_t result = life_word_step(above + w, center + w, below + w);
+            if (w == words - 1) {
+                result &= tail_mask;
+            }
+            out[w] = result;
+            changed |= result ^ cell;
+            if (HASH) {
+                for (uint64_t diff = result ^ cell; diff != 0; diff &= diff - 1) {
+                    hash_delta ^= zobrist_key(x, w * 64 + __builtin_ctzll(diff));
+                }
+            }
+            population += __builtin_popcountll(result);
+            births += __builtin_popcountll(result & ~cell);
+            deaths += __builtin_popcountll(cell & ~result);
+        }
+    }
+    counters.population += population;
+    counters.births += births;
+    counters.deaths += deaths;
+    counters.hash_delta ^= hash_delta;
+    return changed != 0;
+}
+
+#endif // LIFEGAME_BITGRID_H
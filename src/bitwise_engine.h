@@ -0,0 +1,61 @@
+#ifndef LIFEGAME_BITWISEENGINE_H
+#define LIFEGAME_BITWISEENGINE_H
+
+#include <bit_grid.h>
+#include <step_engine.h>
+#include <cstdint>
+#include <utility>
+
+// Dense engine on the bit-packed grid: 64 cells per word, stepped with
+// bitwise adder logic. Cost is proportional to the area of the board and
+// independent of what is on it. Cells are two-state.
+template <int HEIGHT, int WIDTH>
+class BitwiseEngine : public StepEngine<HEIGHT, WIDTH> {
+public:
+    using Grid = BitGrid<HEIGHT, WIDTH>;
+
+    // Steps rows [x_begin, x_end) and words [w_begin, w_end) of `cur` into
+    // `next`, adding to the counters. Returns whether any cell changed.
+    template <bool HASH = false>
+    static bool step_region(const Grid& cur, Grid& next, int32_t x_begin, int32_t x_end,
+                            int32_t w_begin, int32_t w_end, GenerationCounters& counters) {
+        return life_step_rows<HASH>(cur.row(0), next.row(0), Grid::STRIDE, Grid::WORDS, Grid::TAIL_MASK,
+                                    x_begin, x_end, w_begin, w_end, counters);
+    }
+private:
+    Grid grid, next_grid;
+public:
+    const char* name() const override { return "bitwise"; }
+
+    void clear() override { grid.clear(); }
+
+    int32_t get_id(int32_t x, int32_t y) const override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            return grid.get(x, y);
+        }
+        return -1;
+    }
+
+    void set_id(int32_t x, int32_t y, int32_t id) override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            grid.set(x, y, id != 0);
+        }
+    }
+
+    int64_t get_population() const override { return grid.population(); }
+
+    void step(GenerationCounters& counters) override {
+        counters = GenerationCounters {};
+        if (this->hashing) {
+            step_region<true>(grid, next_grid, 0, HEIGHT, 0, Grid::WORDS, counters);
+        } else {
+            step_region<false>(grid, next_grid, 0, HEIGHT, 0, Grid::WORDS, counters);
+        }
+        std::swap(grid, next_grid);
+    }
+
+    const Grid& get_grid() const { return grid; }
+    Grid& get_grid() { return grid; }
+};
+
+#endif // LIFEGAME_BITWISEENGINE_H
@@ -0,0 +1,283 @@
+#ifndef LIFEGAME_BLIT_H
+#define LIFEGAME_BLIT_H
+
+#include <bit_grid.h>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// How copied cells combine with the cells they land on. Cells outside the
+// copied rectangle are never touched, so AND only clears inside it.
+enum class BlitOp { REPLACE, OR, AND, XOR };
+
+// The eight symmetries of a rectangle. For an h x w pattern, cell (x, y)
+// goes to the given cell of the result; rotations are clockwise as drawn,
+// rows running down the screen.
+enum class Symmetry {
+    IDENTITY,        // (x, y)
+    ROTATE_90,       // (y, h - 1 - x)
+    ROTATE_180,      // (h - 1 - x, w - 1 - y)
+    ROTATE_270,      // (w - 1 - y, x)
+    FLIP_ROWS,       // (h - 1 - x, y)
+    FLIP_COLUMNS,    // (x, w - 1 - y)
+    TRANSPOSE,       // (y, x)
+    ANTI_TRANSPOSE   // (w - 1 - y, h - 1 - x)
+};
+
+// The 64 bits of a packed row starting at bit `start`, without branches:
+// the word holding bit `start` and the one after are always read, so for a
+// negative start word -1 must be readable too.
+inline uint64_t row_bits_at(const uint64_t* row, int64_t start) {
+    const uint64_t* word = row + (start >> 6);
+    const int32_t shift = static_cast<int32_t>(start & 63);
+    return (word[0] >> shift) | ((word[1] << 1) << (63 - shift));
+}
+
+inline uint64_t reverse_bits(uint64_t v) {
+    v = ((v >> 1) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1);
+    v = ((v >> 2) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((v & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return __builtin_bswap64(v);
+}
+
+// Transposes a 64 x 64 bit matrix in place: bit j of a[i] swaps with bit i
+// of a[j]. Swaps off-diagonal blocks of halving size, six passes of 32 word
+// operations each.
+inline void transpose_bits(uint64_t a[64]) {
+    uint64_t mask = 0x00000000FFFFFFFFULL;
+    for (int32_t j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+        for (int32_t k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            uint64_t t = ((a[k] >> j) ^ a[k | j]) & mask;
+            a[k] ^= t << j;
+            a[k | j] ^= t;
+        }
+    }
+}
+
+// The shift between source and destination is the same for every word, so
+// each destination word costs two loads, two shifts and the masking of the
+// two end words.
+template <BlitOp OP>
+void blit_bits_as(uint64_t* dst, int32_t dst_y, const uint64_t* src, int32_t src_y, int32_t count) {
+    const int32_t first = dst_y >> 6, last = (dst_y + count - 1) >> 6;
+    const uint64_t head = ~0ULL << (dst_y & 63);
+    const uint64_t tail = ~0ULL >> (63 - ((dst_y + count - 1) & 63));
+    const int64_t start = static_cast<int64_t>(first) * 64 - dst_y + src_y;
+    const uint64_t* from = src + (start >> 6);
+    const int32_t shift = static_cast<int32_t>(start & 63);
+    for (int32_t w = first; w <= last; w++, from++) {
+        const uint64_t mask = (w == first ? head : ~0ULL) & (w == last ? tail : ~0ULL);
+        const uint64_t bits = ((from[0] >> shift) | ((from[1] << 1) << (63 - shift))) & mask;
+        switch (OP) {
+            case BlitOp::REPLACE: dst[w] = (dst[w] & ~mask) | bits; break;
+            case BlitOp::OR:      dst[w] |= bits;                   break;
+            case BlitOp::AND:     dst[w] &= bits | ~mask;           break;
+            case BlitOp::XOR:     dst[w] ^= bits;                   break;
+        }
+    }
+}
+
+// Combines bits [src_y, src_y + count) of a packed row into bits
+// [dst_y, dst_y + count) of another, a word at a time. Both ranges are
+// assumed inside their rows, and the source row must be readable one word
+// either side, as BitGrid and BitRegion rows are.
+inline void blit_bits(uint64_t* dst, int32_t dst_y, const uint64_t* src, int32_t src_y, int32_t count, BlitOp op) {
+    if (count <= 0) {
+        return;
+    }
+    switch (op) {
+        case BlitOp::REPLACE: blit_bits_as<BlitOp::REPLACE>(dst, dst_y, src, src_y, count); break;
+        case BlitOp::OR:      blit_bits_as<BlitOp::OR>(dst, dst_y, src, src_y, count);      break;
+        case BlitOp::AND:     blit_bits_as<BlitOp::AND>(dst, dst_y, src, src_y, count);     break;
+        case BlitOp::XOR:     blit_bits_as<BlitOp::XOR>(dst, dst_y, src, src_y, count);     break;
+    }
+}
+
+// A rectangle of cells packed like a BitGrid row by row, sized at run time:
+// a pattern to stamp or a piece cut from a board. Rows are framed by a zero
+// word on each side for blit_bits() to read into.
+class BitRegion {
+private:
+    int32_t height {0}, width {0};
+    int32_t words {0}, stride {2};
+    std::vector<uint64_t> bits;
+
+    void flip_rows() {
+        for (int32_t x = 0; x < height / 2; x++) {
+            std::swap_ranges(row(x), row(x) + words, row(height - 1 - x));
+        }
+    }
+
+    void flip_columns() {
+        const int32_t pad = words * 64 - width;
+        std::vector<uint64_t> reversed(words + 2, 0);
+        for (int32_t x = 0; x < height; x++) {
+            uint64_t* r = row(x);
+            for (int32_t w = 0; w < words; w++) {
+                reversed[w + 1] = reverse_bits(r[words - 1 - w]);
+            }
+            for (int32_t w = 0; w < words; w++) {
+                r[w] = row_bits_at(reversed.data() + 1, pad + static_cast<int64_t>(w) * 64);
+            }
+        }
+    }
+
+    // 64 x 64 blocks transposed one at a time; rows past the end read as zero.
+    BitRegion transposed() const {
+        BitRegion out(width, height);
+        uint64_t block[64];
+        for (int32_t bx = 0; bx < words; bx++) {
+            for (int32_t by = 0; by < out.words; by++) {
+                for (int32_t i = 0; i < 64; i++) {
+                    const int32_t x = by * 64 + i;
+                    block[i] = x < height ? row(x)[bx] : 0;
+                }
+                transpose_bits(block);
+                for (int32_t i = 0; i < 64 && bx * 64 + i < out.height; i++) {
+                    out.row(bx * 64 + i)[by] = block[i];
+                }
+            }
+        }
+        return out;
+    }
+public:
+    BitRegion() : bits(2, 0) {}
+    BitRegion(int32_t height_, int32_t width_)
+        : height(height_), width(width_), words((width_ + 63) / 64), stride(words + 2),
+          bits(static_cast<size_t>(std::max(height_, 1)) * stride, 0) {}
+
+    // The bounding box of `cells`, {x, y} pairs as LifePatterns lists them,
+    // with its top left corner moved to (0, 0).
+    static BitRegion from_cells(const std::vector< std::pair<int32_t, int32_t> >& cells) {
+        if (cells.empty()) {
+            return BitRegion();
+        }
+        int32_t x_min = INT32_MAX, y_min = INT32_MAX, x_max = INT32_MIN, y_max = INT32_MIN;
+        for (const std::pair<int32_t, int32_t>& cell : cells) {
+            x_min = std::min(x_min, cell.first);
+            x_max = std::max(x_max, cell.first);
+            y_min = std::min(y_min, cell.second);
+            y_max = std::max(y_max, cell.second);
+        }
+        BitRegion region(x_max - x_min + 1, y_max - y_min + 1);
+        for (const std::pair<int32_t, int32_t>& cell : cells) {
+            region.set(cell.first - x_min, cell.second - y_min, true);
+        }
+        return region;
+    }
+
+    // The h x w rectangle of `grid` at (x, y); the part off the board is dead.
+    template <int HEIGHT, int WIDTH>
+    static BitRegion copy_of(const BitGrid<HEIGHT, WIDTH>& grid, int32_t x, int32_t y, int32_t h, int32_t w) {
+        BitRegion region(h, w);
+        const int32_t y0 = std::max(y, 0), y1 = std::min(y + w, WIDTH);
+        for (int32_t i = std::max(0, -x); i < h && x + i < HEIGHT; i++) {
+            blit_bits(region.row(i), y0 - y, grid.row(x + i), y0, y1 - y0, BlitOp::REPLACE);
+        }
+        return region;
+    }
+
+    int32_t get_height() const { return height; }
+    int32_t get_width() const { return width; }
+    int32_t get_words() const { return words; }
+
+    // Word 0 of row x; words -1 and get_words() are padding.
+    uint64_t* row(int32_t x) { return bits.data() + static_cast<size_t>(x) * stride + 1; }
+    const uint64_t* row(int32_t x) const { return bits.data() + static_cast<size_t>(x) * stride + 1; }
+
+    bool get(int32_t x, int32_t y) const { return (row(x)[y >> 6] >> (y & 63)) & 1; }
+
+    void set(int32_t x, int32_t y, bool alive) {
+        uint64_t bit = 1ULL << (y & 63);
+        if (alive) {
+            row(x)[y >> 6] |= bit;
+        } else {
+            row(x)[y >> 6] &= ~bit;
+        }
+    }
+
+    int64_t population() const {
+        int64_t count = 0;
+        for (int32_t x = 0; x < height; x++) {
+            for (int32_t w = 0; w < words; w++) {
+                count += __builtin_popcountll(row(x)[w]);
+            }
+        }
+        return count;
+    }
+
+    // This pattern under `symmetry`; the transposing ones swap height and
+    // width. Stamping one pattern many times is cheapest with each of its
+    // symmetries made once up front.
+    BitRegion transformed(Symmetry symmetry) const {
+        bool transpose = false, rows = false, columns = false;
+        switch (symmetry) {
+            case Symmetry::IDENTITY:                                        break;
+            case Symmetry::ROTATE_90:      transpose = true; columns = true; break;
+            case Symmetry::ROTATE_180:     rows = true; columns = true;      break;
+            case Symmetry::ROTATE_270:     transpose = true; rows = true;    break;
+            case Symmetry::FLIP_ROWS:      rows = true;                      break;
+            case Symmetry::FLIP_COLUMNS:   columns = true;                   break;
+            case Symmetry::TRANSPOSE:      transpose = true;                 break;
+            case Symmetry::ANTI_TRANSPOSE: transpose = rows = columns = true; break;
+        }
+        BitRegion out = transpose ? transposed() : *this;
+        if (rows) {
+            out.flip_rows();
+        }
+        if (columns) {
+            out.flip_columns();
+        }
+        return out;
+    }
+};
+
+// Combines `region` into `grid` with its top left corner at (x, y), clipped
+// to the board.
+template <int HEIGHT, int WIDTH>
+void blit(BitGrid<HEIGHT, WIDTH>& grid, int32_t x, int32_t y, const BitRegion& region, BlitOp op = BlitOp::OR) {
+    const int32_t y0 = std::max(y, 0), y1 = std::min(y + region.get_width(), WIDTH);
+    for (int32_t i = std::max(0, -x); i < region.get_height() && x + i < HEIGHT; i++) {
+        blit_bits(grid.row(x + i), y0, region.row(i), y0 - y, y1 - y0, op);
+    }
+}
+
+// `pattern` under `symmetry` combined into `grid` at (x, y).
+template <int HEIGHT, int WIDTH>
+void stamp(BitGrid<HEIGHT, WIDTH>& grid, int32_t x, int32_t y, const BitRegion& pattern,
+           Symmetry symmetry = Symmetry::IDENTITY, BlitOp op = BlitOp::OR) {
+    if (symmetry == Symmetry::IDENTITY) {
+        blit(grid, x, y, pattern, op);
+    } else {
+        blit(grid, x, y, pattern.transformed(symmetry), op);
+    }
+}
+
+// Combines the h x w rectangle of `src` at (src_x, src_y) into `dst` at
+// (dst_x, dst_y), row by row without an intermediate copy. Only the part of
+// the rectangle that is on both boards is copied. The two rectangles may
+// overlap when both are one board.
+template <int DST_HEIGHT, int DST_WIDTH, int SRC_HEIGHT, int SRC_WIDTH>
+void copy_rect(BitGrid<DST_HEIGHT, DST_WIDTH>& dst, int32_t dst_x, int32_t dst_y,
+               const BitGrid<SRC_HEIGHT, SRC_WIDTH>& src, int32_t src_x, int32_t src_y,
+               int32_t h, int32_t w, BlitOp op = BlitOp::REPLACE) {
+    // Clip the rectangle, relative to its top left corner, to both boards.
+    const int32_t i0 = std::max({ 0, -dst_x, -src_x });
+    const int32_t i1 = std::min({ h, DST_HEIGHT - dst_x, SRC_HEIGHT - src_x });
+    const int32_t j0 = std::max({ 0, -dst_y, -src_y });
+    const int32_t j1 = std::min({ w, DST_WIDTH - dst_y, SRC_WIDTH - src_y });
+    if (i0 >= i1 || j0 >= j1) {
+        return;
+    }
+    if (static_cast<const void*>(&dst) == static_cast<const void*>(&src)) {
+        blit(dst, dst_x + i0, dst_y + j0, BitRegion::copy_of(src, src_x + i0, src_y + j0, i1 - i0, j1 - j0), op);
+        return;
+    }
+    for (int32_t i = i0; i < i1; i++) {
+        blit_bits(dst.row(dst_x + i), dst_y + j0, src.row(src_x + i), src_y + j0, j1 - j0, op);
+    }
+}
+
+#endif // LIFEGAME_BLIT_H
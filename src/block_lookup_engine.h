@@ -0,0 +1,178 @@
+#ifndef LIFEGAME_BLOCKLOOKUPENGINE_H
+#define LIFEGAME_BLOCKLOOKUPENGINE_H
+
+#include <bit_grid.h>
+#include <step_engine.h>
+#include <zobrist.h>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Next states of the 2x2 block in the middle of every 4x4 neighbourhood,
+// for the Life-like rule where bit n of BIRTH / SURVIVE means a dead / live
+// cell with n live neighbours is born / stays. Index bit 4 * r + c is the
+// cell at row r, column c of the 4x4 square; entry bit 2 * r + c is the
+// block's cell at row r, column c.
+template <uint32_t BIRTH, uint32_t SURVIVE>
+struct BlockTable {
+    static_assert(BIRTH < 512 && SURVIVE < 512, "neighbour counts go up to 8");
+
+    std::array<uint8_t, 65536> next {};
+
+    // Next state of the middle of a 3x3 square, bit 3 * r + c being row r,
+    // column c. Block entries are put together from four of these, which
+    // keeps the compiler's work well under its constexpr limits.
+    static constexpr uint8_t cell_next(uint32_t square) {
+        uint32_t count = 0;
+        for (uint32_t bit = 0; bit < 9; bit++) {
+            count += bit != 4 && ((square >> bit) & 1);
+        }
+        return (((((square >> 4) & 1) ? SURVIVE : BIRTH) >> count) & 1);
+    }
+
+    constexpr BlockTable() {
+        std::array<uint8_t, 512> cells {};
+        for (uint32_t square = 0; square < 512; square++) {
+            cells[square] = cell_next(square);
+        }
+        // One 4x4 row at a time, so the top half of the block is looked up
+        // once per first three rows rather than once per entry.
+        for (uint32_t r0 = 0; r0 < 16; r0++) {
+            for (uint32_t r1 = 0; r1 < 16; r1++) {
+                for (uint32_t r2 = 0; r2 < 16; r2++) {
+                    uint32_t top = cells[(r0 & 7) | ((r1 & 7) << 3) | ((r2 & 7) << 6)]
+                                 | cells[(r0 >> 1) | ((r1 >> 1) << 3) | ((r2 >> 1) << 6)] << 1;
+                    uint32_t base = r0 | (r1 << 4) | (r2 << 8);
+                    for (uint32_t r3 = 0; r3 < 16; r3++) {
+                        uint32_t bottom = cells[(r1 & 7) | ((r2 & 7) << 3) | ((r3 & 7) << 6)]
+                                        | cells[(r1 >> 1) | ((r2 >> 1) << 3) | ((r3 >> 1) << 6)] << 1;
+                        next[base | (r3 << 12)] = static_cast<uint8_t>(top | (bottom << 2));
+                    }
+                }
+            }
+        }
+    }
+};
+
+// Bit-packed engine that steps the board two rows by two columns at a time
+// through a 64 KB table: the 4x4 neighbourhood of a 2x2 block is packed into
+// a 16-bit index and one load gives all four next states. It needs nothing
+// beyond shifts and masks, so it is a portable alternative to the adder
+// logic of BitwiseEngine, and the table is worked out by the compiler for
+// whatever rule the engine is instantiated with. Storage is the BitGrid the
+// other bit-packed engines use.
+template <int HEIGHT, int WIDTH, uint32_t BIRTH = 1u << 3, uint32_t SURVIVE = (1u << 2) | (1u << 3)>
+class BlockLookupEngine : public StepEngine<HEIGHT, WIDTH> {
+public:
+    using Grid = BitGrid<HEIGHT, WIDTH>;
+
+    static constexpr BlockTable<BIRTH, SURVIVE> TABLE {};
+private:
+    Grid grid, next_grid;
+    // Stands in for row HEIGHT + 1 below an odd last row, and takes the
+    // results for row HEIGHT, which must stay dead.
+    std::vector<uint64_t> zero_row, spare_row;
+
+    // Next states of row words w of x and x + 1 from rows x - 1 to x + 2.
+    static void block_word(const uint64_t* const rows[4], int32_t w, uint64_t& top, uint64_t& bottom) {
+        // v[i] bit k is column 64 * w + k - 1, so block j reads bits 2j to
+        // 2j + 3; the two columns past the word come from `spill`.
+        uint64_t v[4], spill[4];
+        for (int32_t i = 0; i < 4; i++) {
+            v[i] = (rows[i][w] << 1) | (rows[i][w - 1] >> 63);
+            spill[i] = (rows[i][w] >> 63) | ((rows[i][w + 1] & 1) << 1);
+        }
+        const uint8_t* table = TABLE.next.data();
+        uint64_t out_top = 0, out_bottom = 0;
+        for (int32_t j = 0; j < 31; j++) {
+            uint32_t index = static_cast<uint32_t>((v[0] & 15) | ((v[1] & 15) << 4) | ((v[2] & 15) << 8) |
+                                                   ((v[3] & 15) << 12));
+            uint64_t block = table[index];
+            out_top |= (block & 3) << (2 * j);
+            out_bottom |= (block >> 2) << (2 * j);
+            v[0] >>= 2;
+            v[1] >>= 2;
+            v[2] >>= 2;
+            v[3] >>= 2;
+        }
+        uint32_t index = static_cast<uint32_t>((v[0] | (spill[0] << 2)) | ((v[1] | (spill[1] << 2)) << 4) |
+                                               ((v[2] | (spill[2] << 2)) << 8) | ((v[3] | (spill[3] << 2)) << 12));
+        uint64_t block = table[index];
+        top = out_top | ((block & 3) << 62);
+        bottom = out_bottom | ((block >> 2) << 62);
+    }
+
+    template <bool HASH>
+    void step_rows(GenerationCounters& counters) {
+        int64_t population = 0, births = 0, deaths = 0;
+        uint64_t hash_delta = 0;
+        for (int32_t x = 0; x < HEIGHT; x += 2) {
+            const uint64_t* const rows[4] = {
+                grid.row(x - 1), grid.row(x), grid.row(x + 1),
+                x + 2 <= HEIGHT ? grid.row(x + 2) : zero_row.data() + 1
+            };
+            const bool pair = x + 1 < HEIGHT;
+            uint64_t* out[2] = {next_grid.row(x), pair ? next_grid.row(x + 1) : spare_row.data() + 1};
+            for (int32_t w = 0; w < Grid::WORDS; w++) {
+                uint64_t result[2];
+                block_word(rows, w, result[0], result[1]);
+                if (w == Grid::WORDS - 1) {
+                    result[0] &= Grid::TAIL_MASK;
+                    result[1] &= Grid::TAIL_MASK;
+                }
+                for (int32_t i = 0; i < (pair ? 2 : 1); i++) {
+                    uint64_t cell = rows[i + 1][w];
+                    out[i][w] = result[i];
+                    population += __builtin_popcountll(result[i]);
+                    births += __builtin_popcountll(result[i] & ~cell);
+                    deaths += __builtin_popcountll(cell & ~result[i]);
+                    if (HASH) {
+                        for (uint64_t diff = result[i] ^ cell; diff != 0; diff &= diff - 1) {
+                            hash_delta ^= zobrist_key(x + i, w * 64 + __builtin_ctzll(diff));
+                        }
+                    }
+                }
+            }
+        }
+        counters.population = population;
+        counters.births = births;
+        counters.deaths = deaths;
+        counters.hash_delta = hash_delta;
+    }
+public:
+    BlockLookupEngine() : zero_row(Grid::STRIDE, 0), spare_row(Grid::STRIDE, 0) {}
+
+    const char* name() const override { return "block_lookup"; }
+
+    void clear() override { grid.clear(); }
+
+    int32_t get_id(int32_t x, int32_t y) const override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            return grid.get(x, y);
+        }
+        return -1;
+    }
+
+    void set_id(int32_t x, int32_t y, int32_t id) override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            grid.set(x, y, id != 0);
+        }
+    }
+
+    int64_t get_population() const override { return grid.population(); }
+
+    void step(GenerationCounters& counters) override {
+        if (this->hashing) {
+            step_rows<true>(counters);
+        } else {
+            step_rows<false>(counters);
+        }
+        std::swap(grid, next_grid);
+    }
+
+    const Grid& get_grid() const { return grid; }
+    Grid& get_grid() { return grid; }
+};
+
+#endif // LIFEGAME_BLOCKLOOKUPENGINE_H
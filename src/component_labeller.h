@@ -0,0 +1,229 @@
+#ifndef LIFEGAME_COMPONENTLABELLER_H
+#define LIFEGAME_COMPONENTLABELLER_H
+
+#include <bit_grid.h>
+#include <life_trace.h>
+#include <thread_pool.h>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Splits the live cells of a bit-packed board into components: two cells are
+// in the same one if a chain of live cells joins them with each step at most
+// `merge_radius` rows and columns long (radius 1 is 8-connectivity).
+//
+// Works on runs of live cells rather than cells. Runs are read straight off
+// the packed words, then joined with union-find in bands of TILE_ROWS rows,
+// one band per task; only rows within the radius of a band edge are joined
+// afterwards, on the calling thread. Each component gets its bounding box,
+// population and cells, in row-major order, in one shared cell list.
+template <int HEIGHT, int WIDTH>
+class ComponentLabeller {
+public:
+    using Grid = BitGrid<HEIGHT, WIDTH>;
+    using Cell = std::pair<int32_t, int32_t>;
+
+    static constexpr int32_t TILE_ROWS = 64;
+    static constexpr int32_t BANDS = (HEIGHT + TILE_ROWS - 1) / TILE_ROWS;
+
+    struct Component {
+        int32_t x_min, y_min, x_max, y_max; // inclusive
+        int64_t population;
+        size_t begin, end;                  // into get_cells()
+    };
+private:
+    struct Run {
+        int32_t begin, end; // columns, inclusive
+    };
+
+    int32_t merge_radius {1};
+    std::vector<size_t> row_begin; // runs of row x are [row_begin[x], row_begin[x + 1])
+    std::vector<Run> runs;
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> component_of;
+    std::vector<size_t> cell_offset;
+    std::vector<Component> components;
+    std::vector<Cell> cells;
+    ThreadPool pool;
+
+    // Live cells starting / ending a run in word w of a row.
+    static uint64_t run_starts(const uint64_t* r, int32_t w) {
+        return r[w] & ~((r[w] << 1) | (r[w - 1] >> 63));
+    }
+    static uint64_t run_ends(const uint64_t* r, int32_t w) {
+        return r[w] & ~((r[w] >> 1) | (r[w + 1] << 63));
+    }
+
+    uint32_t find(uint32_t i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+    uint32_t find_root(uint32_t i) const {
+        while (parent[i] != i) {
+            i = parent[i];
+        }
+        return i;
+    }
+    // The smaller index becomes the root, so a root is always its
+    // component's first run in row-major order.
+    void unite(uint32_t a, uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a < b) {
+            parent[b] = a;
+        } else if (b < a) {
+            parent[a] = b;
+        }
+    }
+
+    // Joins the runs of row x with those of rows [x_from, x) and with the
+    // earlier runs of row x itself.
+    void join_row(int32_t x, int32_t x_from) {
+        const int32_t r = merge_radius;
+        for (int32_t above = std::max(0, x_from); above < x; above++) {
+            size_t j = row_begin[above];
+            const size_t j_end = row_begin[above + 1];
+            for (size_t i = row_begin[x]; i < row_begin[x + 1]; i++) {
+                while (j < j_end && runs[j].end < runs[i].begin - r) {
+                    j++;
+                }
+                for (size_t k = j; k < j_end && runs[k].begin <= runs[i].end + r; k++) {
+                    unite(static_cast<uint32_t>(i), static_cast<uint32_t>(k));
+                }
+            }
+        }
+        for (size_t i = row_begin[x] + 1; i < row_begin[x + 1]; i++) {
+            for (size_t k = i; k > row_begin[x] && runs[k - 1].end >= runs[i].begin - r; k--) {
+                unite(static_cast<uint32_t>(i), static_cast<uint32_t>(k - 1));
+            }
+        }
+    }
+public:
+    // `threads` counts the calling thread; 0 means one per hardware thread.
+    explicit ComponentLabeller(size_t threads = 0) : row_begin(HEIGHT + 1, 0), pool(threads) {}
+
+    // Cells up to `radius` rows and columns apart join; at least 1.
+    void set_merge_radius(int32_t radius) { merge_radius = std::max(1, radius); }
+    int32_t get_merge_radius() const { return merge_radius; }
+
+    // Labels the live cells of `grid`. Components come in the row-major
+    // order of their first cell.
+    const std::vector<Component>& label(const Grid& grid) {
+        LIFE_TRACE_SCOPE("label_components");
+        // Count the runs of every row, then read them out at known offsets.
+        std::vector<size_t> counts(HEIGHT, 0);
+        pool.parallel_for(BANDS, [&](size_t band) {
+            const int32_t x_begin = static_cast<int32_t>(band) * TILE_ROWS;
+            for (int32_t x = x_begin; x < std::min(HEIGHT, x_begin + TILE_ROWS); x++) {
+                const uint64_t* r = grid.row(x);
+                size_t count = 0;
+                for (int32_t w = 0; w < Grid::WORDS; w++) {
+                    count += __builtin_popcountll(run_starts(r, w));
+                }
+                counts[x] = count;
+            }
+        });
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            row_begin[x + 1] = row_begin[x] + counts[x];
+        }
+        runs.resize(row_begin[HEIGHT]);
+        parent.resize(runs.size());
+
+        pool.parallel_for(BANDS, [&](size_t band) {
+            const int32_t x_begin = static_cast<int32_t>(band) * TILE_ROWS;
+            const int32_t x_end = std::min(HEIGHT, x_begin + TILE_ROWS);
+            for (int32_t x = x_begin; x < x_end; x++) {
+                const uint64_t* r = grid.row(x);
+                size_t i = row_begin[x];
+                for (int32_t w = 0; w < Grid::WORDS; w++) {
+                    for (uint64_t starts = run_starts(r, w); starts != 0; starts &= starts - 1) {
+                        runs[i++].begin = w * 64 + __builtin_ctzll(starts);
+                    }
+                }
+                i = row_begin[x];
+                for (int32_t w = 0; w < Grid::WORDS; w++) {
+                    for (uint64_t ends = run_ends(r, w); ends != 0; ends &= ends - 1) {
+                        runs[i++].end = w * 64 + __builtin_ctzll(ends);
+                    }
+                }
+                for (i = row_begin[x]; i < row_begin[x + 1]; i++) {
+                    parent[i] = static_cast<uint32_t>(i);
+                }
+            }
+            // Unions inside the band only ever touch the band's own runs.
+            for (int32_t x = x_begin; x < x_end; x++) {
+                join_row(x, std::max(x_begin, x - merge_radius));
+            }
+        });
+        for (int32_t band = 1; band < BANDS; band++) {
+            const int32_t x_begin = band * TILE_ROWS;
+            for (int32_t x = x_begin; x < std::min(HEIGHT, x_begin + merge_radius); x++) {
+                join_row(x, x - merge_radius);
+            }
+        }
+
+        // Roots are final now; resolve every run without writing to parent.
+        component_of.resize(runs.size());
+        pool.parallel_for(BANDS, [&](size_t band) {
+            const int32_t x_begin = static_cast<int32_t>(band) * TILE_ROWS;
+            const int32_t x_end = std::min(HEIGHT, x_begin + TILE_ROWS);
+            for (size_t i = row_begin[x_begin]; i < row_begin[x_end]; i++) {
+                component_of[i] = find_root(static_cast<uint32_t>(i));
+            }
+        });
+
+        // Number the components and size them, one pass over the runs.
+        components.clear();
+        cell_offset.resize(runs.size());
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            for (size_t i = row_begin[x]; i < row_begin[x + 1]; i++) {
+                const Run& run = runs[i];
+                if (component_of[i] == i) {
+                    component_of[i] = static_cast<uint32_t>(components.size());
+                    components.push_back(Component {x, run.begin, x, run.end, 0, 0, 0});
+                } else {
+                    component_of[i] = component_of[component_of[i]];
+                }
+                Component& component = components[component_of[i]];
+                component.y_min = std::min(component.y_min, run.begin);
+                component.y_max = std::max(component.y_max, run.end);
+                component.x_max = x;
+                component.population += run.end - run.begin + 1;
+            }
+        }
+        size_t total = 0;
+        for (Component& component : components) {
+            component.begin = component.end = total;
+            total += component.population;
+        }
+        for (size_t i = 0; i < runs.size(); i++) {
+            Component& component = components[component_of[i]];
+            cell_offset[i] = component.end;
+            component.end += runs[i].end - runs[i].begin + 1;
+        }
+
+        cells.resize(total);
+        pool.parallel_for(BANDS, [&](size_t band) {
+            const int32_t x_begin = static_cast<int32_t>(band) * TILE_ROWS;
+            const int32_t x_end = std::min(HEIGHT, x_begin + TILE_ROWS);
+            for (int32_t x = x_begin; x < x_end; x++) {
+                for (size_t i = row_begin[x]; i < row_begin[x + 1]; i++) {
+                    Cell* out = cells.data() + cell_offset[i];
+                    for (int32_t y = runs[i].begin; y <= runs[i].end; y++) {
+                        *out++ = Cell {x, y};
+                    }
+                }
+            }
+        });
+        return components;
+    }
+
+    const std::vector<Component>& get_components() const { return components; }
+    const std::vector<Cell>& get_cells() const { return cells; }
+};
+
+#endif // LIFEGAME_COMPONENTLABELLER_H
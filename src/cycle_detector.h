@@ -0,0 +1,107 @@
+#ifndef LIFEGAME_CYCLEDETECTOR_H
+#define LIFEGAME_CYCLEDETECTOR_H
+
+#include <arena.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Spots boards that died out, froze or fell into a cycle, from the board hash
+// of each generation. A hash seen again P generations later makes a
+// candidate; the board is then snapshotted and compared cell for cell with
+// the board P generations on, so a reported cycle is never a hash collision.
+// Extinction is taken from the population directly. `Snapshot` is whatever
+// copy of the board the caller can make cheaply and compare with ==.
+template <class Snapshot>
+class CycleDetector {
+public:
+    enum Kind { NONE, EXTINCT, STILL_LIFE, OSCILLATING };
+
+    struct Result {
+        Kind kind {NONE};
+        uint64_t generation {0}; // the board repeats from here on
+        int32_t period {0};
+    };
+private:
+    struct Entry {
+        uint64_t generation;
+        uint64_t hash;
+    };
+
+    int32_t max_period;
+    std::vector< Entry, ArenaAllocator<Entry> > history; // ring of the last max_period hashes
+    size_t next_slot {0};
+    Result result {};
+
+    std::unique_ptr<Snapshot> snapshot;
+    std::unique_ptr<Snapshot> scratch;
+    uint64_t candidate_generation {0};
+    int32_t candidate_period {0};
+public:
+    explicit CycleDetector(int32_t max_period_ = 64) : max_period(max_period_ < 1 ? 1 : max_period_) {}
+
+    // Forgets everything, e.g. after the board was edited.
+    void reset() {
+        history.clear();
+        next_slot = 0;
+        result = Result {};
+        candidate_period = 0;
+    }
+
+    // Feeds one generation. `fetch(Snapshot&)` copies out the current board and
+    // is only called to snapshot or confirm a candidate. Returns true on the
+    // generation a result is settled.
+    template <class Fetch>
+    bool observe(uint64_t generation, uint64_t hash, int64_t population, Fetch fetch) {
+        if (result.kind != NONE) {
+            return false;
+        }
+        if (population == 0) {
+            result = Result {EXTINCT, generation, 1};
+            return true;
+        }
+
+        if (candidate_period != 0 && generation == candidate_generation + candidate_period) {
+            if (!scratch) {
+                scratch = std::make_unique<Snapshot>();
+            }
+            fetch(*scratch);
+            if (*scratch == *snapshot) {
+                result = Result {candidate_period == 1 ? STILL_LIFE : OSCILLATING,
+                                 candidate_generation, candidate_period};
+                return true;
+            }
+            candidate_period = 0; // collision
+        }
+
+        if (candidate_period == 0) {
+            // Most recent match first, so P is the smallest period seen.
+            for (size_t i = 0; i < history.size(); i++) {
+                const Entry& entry = history[(next_slot + history.size() - 1 - i) % history.size()];
+                if (entry.hash == hash && generation - entry.generation <= static_cast<uint64_t>(max_period)) {
+                    if (!snapshot) {
+                        snapshot = std::make_unique<Snapshot>();
+                    }
+                    fetch(*snapshot);
+                    candidate_generation = generation;
+                    candidate_period = static_cast<int32_t>(generation - entry.generation);
+                    break;
+                }
+            }
+        }
+
+        if (history.size() < static_cast<size_t>(max_period)) {
+            history.push_back(Entry {generation, hash});
+            next_slot = history.size() % max_period;
+        } else {
+            history[next_slot] = Entry {generation, hash};
+            next_slot = (next_slot + 1) % max_period;
+        }
+        return false;
+    }
+
+    const Result& get_result() const { return result; }
+    int32_t get_max_period() const { return max_period; }
+};
+
+#endif // LIFEGAME_CYCLEDETECTOR_H
@@ -0,0 +1,128 @@
+#ifndef LIFEGAME_EDITQUEUE_H
+#define LIFEGAME_EDITQUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Unbounded multi-producer single-consumer queue, after Vyukov's intrusive
+// design. Producers link a node in with one atomic exchange and never wait;
+// the consumer takes nodes from the other end without atomics read-modify-
+// write. A producer caught between its exchange and its link makes the
+// consumer see the queue as empty for a moment, which only delays that item.
+template <class T>
+class MpscQueue {
+private:
+    struct Node {
+        std::atomic<Node*> next {nullptr};
+        T value {};
+    };
+
+    alignas(64) std::atomic<Node*> head;   // producers
+    alignas(64) Node* tail;                // consumer
+    Node stub;
+
+    void link(Node* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // Unlinks the oldest node, or returns null if there is none yet.
+    Node* unlink() {
+        Node* first = tail;
+        Node* next = first->next.load(std::memory_order_acquire);
+        if (first == &stub) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail = next;
+            first = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail = next;
+            return first;
+        }
+        if (first != head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        link(&stub);
+        next = first->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail = next;
+            return first;
+        }
+        return nullptr;
+    }
+public:
+    MpscQueue() : head(&stub), tail(&stub) {}
+
+    ~MpscQueue() {
+        while (Node* node = unlink()) {
+            delete node;
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Any thread.
+    void push(T value) {
+        Node* node = new Node;
+        node->value = std::move(value);
+        link(node);
+    }
+
+    // Consumer thread only.
+    bool pop(T& value) {
+        Node* node = unlink();
+        if (node == nullptr) {
+            return false;
+        }
+        value = std::move(node->value);
+        delete node;
+        return true;
+    }
+};
+
+// One edit of the board. Cells are painted with `id`; a stamp paints the
+// pattern's cells offset by (x, y) and leaves the rest alone.
+struct EditCommand {
+    enum Kind { SET_CELL, FILL_RECT, STAMP };
+
+    Kind kind {SET_CELL};
+    int32_t x {0}, y {0};
+    int32_t height {1}, width {1};   // FILL_RECT
+    int32_t id {1};
+    std::vector< std::pair<int32_t, int32_t> > cells;   // STAMP
+
+    static EditCommand set_cell(int32_t x, int32_t y, int32_t id) {
+        EditCommand command;
+        command.x = x;
+        command.y = y;
+        command.id = id;
+        return command;
+    }
+
+    static EditCommand fill_rect(int32_t x, int32_t y, int32_t height, int32_t width, int32_t id) {
+        EditCommand command = set_cell(x, y, id);
+        command.kind = FILL_RECT;
+        command.height = height;
+        command.width = width;
+        return command;
+    }
+
+    static EditCommand stamp(std::vector< std::pair<int32_t, int32_t> > cells, int32_t x, int32_t y,
+                             int32_t id = 1) {
+        EditCommand command = set_cell(x, y, id);
+        command.kind = STAMP;
+        command.cells = std::move(cells);
+        return command;
+    }
+};
+
+using EditQueue = MpscQueue<EditCommand>;
+
+#endif // LIFEGAME_EDITQUEUE_H
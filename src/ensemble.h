@@ -0,0 +1,160 @@
+#ifndef LIFEGAME_ENSEMBLE_H
+#define LIFEGAME_ENSEMBLE_H
+
+#include <bit_grid.h>
+#include <cycle_detector.h>
+#include <life_trace.h>
+#include <thread_pool.h>
+#include <zobrist.h>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Many independent boards of one size, for Monte Carlo runs over soups. All
+// boards and both of their generation buffers live in one arena, each board
+// padded to whole cache lines so threads never share one. run() steps every
+// board to its own end on the thread pool, one board per task, with no
+// synchronisation between generations, and reports how each one ended.
+template <int HEIGHT, int WIDTH>
+class Ensemble {
+public:
+    using Grid = BitGrid<HEIGHT, WIDTH>;
+    using Detector = CycleDetector< std::vector<uint64_t> >;
+
+    static constexpr int32_t STRIDE = Grid::STRIDE;
+    static constexpr size_t BOARD_WORDS = (static_cast<size_t>(HEIGHT + 2) * STRIDE + 7) & ~static_cast<size_t>(7);
+
+    struct Outcome {
+        int64_t population {0};
+        uint64_t generations {0};             // stepped by the last run()
+        typename Detector::Kind kind {Detector::NONE};
+        uint64_t settled_generation {0};      // repeats from here on, if settled
+        int32_t period {0};
+    };
+private:
+    size_t boards;
+    std::vector<uint64_t> storage;
+    uint64_t* arena;
+    std::vector<uint8_t> parity; // which of the two buffers holds the board
+    std::vector<Outcome> outcomes;
+    ThreadPool pool;
+
+    uint64_t* buffer(size_t board, int32_t which) {
+        return arena + (board * 2 + which) * BOARD_WORDS;
+    }
+    // Word 0 of row 0 of the board's current buffer.
+    uint64_t* cells(size_t board) {
+        return buffer(board, parity[board]) + STRIDE + 1;
+    }
+
+    uint64_t board_hash(size_t board) {
+        const uint64_t* base = cells(board);
+        uint64_t hash = 0;
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            for (int32_t w = 0; w < Grid::WORDS; w++) {
+                for (uint64_t word = base[x * STRIDE + w]; word != 0; word &= word - 1) {
+                    hash ^= zobrist_key(x, w * 64 + __builtin_ctzll(word));
+                }
+            }
+        }
+        return hash;
+    }
+
+    void run_board(size_t board, uint64_t max_generations, int32_t max_period) {
+        LIFE_TRACE_SCOPE("ensemble_board");
+        Detector detector(max_period);
+        Outcome outcome;
+        uint64_t hash = board_hash(board);
+        int64_t population = 0;
+        // Kept local while stepping: neighbouring boards' parity bytes share
+        // a cache line.
+        int32_t which = parity[board];
+        for (uint64_t generation = 1; generation <= max_generations; generation++) {
+            GenerationCounters counters;
+            const uint64_t* cur = buffer(board, which) + STRIDE + 1;
+            uint64_t* next = buffer(board, which ^ 1) + STRIDE + 1;
+            life_step_rows<true>(cur, next, STRIDE, Grid::WORDS, Grid::TAIL_MASK,
+                                 0, HEIGHT, 0, Grid::WORDS, counters);
+            which ^= 1;
+            hash ^= counters.hash_delta;
+            population = counters.population;
+            outcome.generations = generation;
+
+            const uint64_t* now = next;
+            bool settled = detector.observe(generation, hash, population, [&](std::vector<uint64_t>& out) {
+                out.assign(now - STRIDE - 1, now - STRIDE - 1 + BOARD_WORDS);
+            });
+            if (settled) {
+                outcome.kind = detector.get_result().kind;
+                outcome.settled_generation = detector.get_result().generation;
+                outcome.period = detector.get_result().period;
+                break;
+            }
+        }
+        parity[board] = static_cast<uint8_t>(which);
+        outcome.population = population;
+        outcomes[board] = outcome;
+    }
+public:
+    // `threads` counts the calling thread; 0 means one per hardware thread.
+    explicit Ensemble(size_t board_count, size_t threads = 0)
+        : boards(board_count), storage(board_count * 2 * BOARD_WORDS + 8, 0),
+          parity(board_count, 0), outcomes(board_count), pool(threads) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(storage.data());
+        arena = storage.data() + ((64 - address % 64) % 64) / sizeof(uint64_t);
+    }
+
+    size_t size() const { return boards; }
+    size_t threads() const { return pool.size(); }
+
+    int32_t get_id(size_t board, int32_t x, int32_t y) {
+        if (board < boards && 0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            return (cells(board)[x * STRIDE + (y >> 6)] >> (y & 63)) & 1;
+        }
+        return -1;
+    }
+
+    void set_id(size_t board, int32_t x, int32_t y, int32_t id) {
+        if (board < boards && 0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            uint64_t& word = cells(board)[x * STRIDE + (y >> 6)];
+            uint64_t bit = 1ULL << (y & 63);
+            word = id != 0 ? (word | bit) : (word & ~bit);
+        }
+    }
+
+    void clear(size_t board) {
+        std::fill(buffer(board, 0), buffer(board, 0) + 2 * BOARD_WORDS, 0);
+    }
+
+    // Fills every board with an independent random soup; board b is seeded
+    // from `seed` + b, so any single board can be reproduced on its own.
+    void fill_random(double density, uint64_t seed) {
+        pool.parallel_for(boards, [&](size_t board) {
+            clear(board);
+            std::mt19937_64 gen(seed + board);
+            std::bernoulli_distribution alive(density);
+            for (int32_t x = 0; x < HEIGHT; x++) {
+                for (int32_t y = 0; y < WIDTH; y++) {
+                    if (alive(gen)) {
+                        set_id(board, x, y, 1);
+                    }
+                }
+            }
+        });
+    }
+
+    // Steps every board until it dies out, freezes or cycles with period up
+    // to `max_period`, or for `max_generations`, whichever comes first.
+    const std::vector<Outcome>& run(uint64_t max_generations, int32_t max_period = 64) {
+        LIFE_TRACE_SCOPE("ensemble_run");
+        pool.parallel_for(boards, [&](size_t board) {
+            run_board(board, max_generations, max_period);
+        });
+        return outcomes;
+    }
+
+    const std::vector<Outcome>& get_outcomes() const { return outcomes; }
+};
+
+#endif // LIFEGAME_ENSEMBLE_H
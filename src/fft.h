@@ -0,0 +1,92 @@
+#ifndef LIFEGAME_FFT_H
+#define LIFEGAME_FFT_H
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// In-place iterative radix-2 FFT of one power-of-two length. Twiddles and the
+// bit-reversal order are worked out once, when the plan is made; transforms
+// only read them, so one plan can be shared by any number of threads.
+// Products are written out by hand: std::complex's operator* checks for
+// infinities and is far slower without -ffast-math.
+class Fft {
+public:
+    using Complex = std::complex<float>;
+private:
+    static constexpr double PI = 3.14159265358979323846;
+
+    size_t n {0};
+    std::vector<Complex> twiddles;  // e^(-2 pi i k / n), k < n / 2
+    std::vector<uint32_t> reversed;
+
+    static Complex mul(Complex a, Complex b) {
+        return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+    }
+
+    template <bool INVERSE>
+    void transform(Complex* data) const {
+        for (size_t i = 0; i < n; i++) {
+            if (i < reversed[i]) {
+                std::swap(data[i], data[reversed[i]]);
+            }
+        }
+        for (size_t half = 1; half < n; half *= 2) {
+            const size_t step = n / (2 * half);
+            for (size_t start = 0; start < n; start += 2 * half) {
+                for (size_t k = 0; k < half; k++) {
+                    Complex w = twiddles[k * step];
+                    if (INVERSE) {
+                        w = std::conj(w);
+                    }
+                    Complex odd = mul(w, data[start + k + half]);
+                    Complex even = data[start + k];
+                    data[start + k] = even + odd;
+                    data[start + k + half] = even - odd;
+                }
+            }
+        }
+    }
+public:
+    Fft() = default;
+
+    explicit Fft(size_t size) : n(size), twiddles(size / 2), reversed(size) {
+        for (size_t k = 0; k < size / 2; k++) {
+            double angle = -2.0 * PI * static_cast<double>(k) / static_cast<double>(size);
+            twiddles[k] = Complex(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+        }
+        int32_t bits = 0;
+        while ((static_cast<size_t>(1) << bits) < size) {
+            bits++;
+        }
+        for (size_t i = 0; i < size; i++) {
+            uint32_t r = 0;
+            for (int32_t b = 0; b < bits; b++) {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            reversed[i] = r;
+        }
+    }
+
+    size_t size() const { return n; }
+
+    // Smallest power of two not below `value`.
+    static size_t round_up(size_t value) {
+        size_t size = 1;
+        while (size < value) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    void forward(Complex* data) const { transform<false>(data); }
+    // Unscaled: inverse(forward(x)) is n * x.
+    void inverse(Complex* data) const { transform<true>(data); }
+
+    static Complex multiply(Complex a, Complex b) { return mul(a, b); }
+};
+
+#endif // LIFEGAME_FFT_H
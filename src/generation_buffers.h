@@ -0,0 +1,141 @@
+#ifndef LIFEGAME_GENERATIONBUFFERS_H
+#define LIFEGAME_GENERATIONBUFFERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Pool of board buffers addressed by index, one of them the current
+// generation. A step writes into a free buffer and publishes it, which only
+// moves the index, so nothing is copied or swapped element by element.
+// Readers on any thread pin the current buffer through a View; a pinned
+// buffer is never handed out for writing, so a view keeps showing its
+// generation however many are stepped meanwhile. Buffers are allocated the
+// first time they are needed, up to MAX_BUFFERS; with all of them pinned
+// the writer waits for a reader to let go.
+template <class Buffer>
+class GenerationBuffers {
+public:
+    static constexpr int32_t MAX_BUFFERS = 8;
+
+    // Read-only hold on one published buffer.
+    class View {
+    private:
+        const GenerationBuffers* owner {nullptr};
+        int32_t index {-1};
+        uint64_t view_generation {0};
+
+        friend class GenerationBuffers;
+        View(const GenerationBuffers* owner_, int32_t index_, uint64_t generation_)
+            : owner(owner_), index(index_), view_generation(generation_) {}
+    public:
+        View() = default;
+        View(View&& other) noexcept : owner(other.owner), index(other.index), view_generation(other.view_generation) {
+            other.owner = nullptr;
+        }
+        View& operator=(View&& other) noexcept {
+            if (this != &other) {
+                release();
+                owner = other.owner;
+                index = other.index;
+                view_generation = other.view_generation;
+                other.owner = nullptr;
+            }
+            return *this;
+        }
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+        ~View() { release(); }
+
+        void release() {
+            if (owner != nullptr) {
+                owner->pins[index].fetch_sub(1, std::memory_order_release);
+                owner = nullptr;
+            }
+        }
+
+        const Buffer& get() const { return *owner->buffers[index]; }
+        const Buffer& operator*() const { return get(); }
+        const Buffer* operator->() const { return &get(); }
+        uint64_t generation() const { return view_generation; }
+    };
+private:
+    std::unique_ptr<Buffer> buffers[MAX_BUFFERS];
+    mutable std::atomic<int32_t> pins[MAX_BUFFERS] {};
+    uint64_t generations[MAX_BUFFERS] {};
+    int32_t allocated {0};
+    std::atomic<int32_t> current {0};
+    int32_t next {-1};
+
+    bool pinned(int32_t i) const { return pins[i].load(std::memory_order_seq_cst) != 0; }
+public:
+    GenerationBuffers() {
+        buffers[0] = std::make_unique<Buffer>();
+        allocated = 1;
+    }
+
+    GenerationBuffers(const GenerationBuffers&) = delete;
+    GenerationBuffers& operator=(const GenerationBuffers&) = delete;
+
+    // Writer side; one thread.
+    Buffer& get_current() { return *buffers[current.load(std::memory_order_relaxed)]; }
+    const Buffer& get_current() const { return *buffers[current.load(std::memory_order_relaxed)]; }
+    uint64_t get_generation() const { return generations[current.load(std::memory_order_relaxed)]; }
+
+    // A buffer nobody reads, to write the next generation into. Its contents
+    // are whatever it held last.
+    Buffer& acquire_next() {
+        const int32_t now = current.load(std::memory_order_relaxed);
+        for (;;) {
+            for (int32_t i = 0; i < allocated; i++) {
+                if (i != now && !pinned(i)) {
+                    next = i;
+                    return *buffers[i];
+                }
+            }
+            if (allocated < MAX_BUFFERS) {
+                buffers[allocated] = std::make_unique<Buffer>();
+                next = allocated++;
+                return *buffers[next];
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // Makes the buffer from acquire_next() current, as `generation`.
+    void publish(uint64_t generation) {
+        generations[next] = generation;
+        current.store(next, std::memory_order_seq_cst);
+        next = -1;
+    }
+
+    // The current buffer for editing in place. If readers hold it, it is
+    // copied to a free buffer first so their view does not change.
+    Buffer& edit_current() {
+        const int32_t now = current.load(std::memory_order_relaxed);
+        if (!pinned(now)) {
+            return *buffers[now];
+        }
+        Buffer& copy = acquire_next();
+        copy = *buffers[now];
+        publish(generations[now]);
+        return copy;
+    }
+
+    // Reader side; any thread. Pins the current buffer.
+    View read() const {
+        for (;;) {
+            int32_t i = current.load(std::memory_order_seq_cst);
+            pins[i].fetch_add(1, std::memory_order_seq_cst);
+            if (current.load(std::memory_order_seq_cst) == i) {
+                return View(this, i, generations[i]);
+            }
+            pins[i].fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    int32_t get_allocated() const { return allocated; }
+};
+
+#endif // LIFEGAME_GENERATIONBUFFERS_H
@@ -0,0 +1,294 @@
+#ifndef LIFEGAME_GENERATIONSENGINE_H
+#define LIFEGAME_GENERATIONSENGINE_H
+
+#include <step_engine.h>
+#include <zobrist.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Engine for multi-state outer-totalistic rules: the next state of a cell is
+// table[state][n], where n is the number of its eight neighbours in a state
+// that counts as live. Generations rules (Brian's Brain, Star Wars, ...) are
+// the common case: 0 is dead, 1 alive, and 2 to C - 1 are dying states a cell
+// passes through one per generation before it is dead again; only state 1
+// counts. Life-like rules are the C = 2 case.
+//
+// States are bytes. Live flags and neighbour counts are worked out eight
+// cells to a word, one per byte, and the table is one flat byte array
+// indexed by state * 16 + n, so a step costs the same for any rule and any
+// number of states. Ids outside [0, states) are stored as 1.
+template <int HEIGHT, int WIDTH>
+class GenerationsEngine : public StepEngine<HEIGHT, WIDTH> {
+public:
+    using Field = typename StepEngine<HEIGHT, WIDTH>::Field;
+
+    static constexpr int32_t MAX_STATES = 256;
+    // Room for the zero frame plus whole words on both ends of a row.
+    static constexpr int32_t STRIDE = ((WIDTH + 2 + 7) & ~7) + 8;
+private:
+    static constexpr uint64_t ONES = 0x0101010101010101ULL;
+
+    int32_t states {2};
+    std::vector<uint8_t> table;     // MAX_STATES * 16
+    std::array<uint8_t, MAX_STATES> counted {};
+    bool only_one_counts {true};
+
+    // Rows of STRIDE bytes with a zero row above and below and cell (x, y)
+    // at row x + 1, byte y + 1.
+    std::vector<uint8_t> cells, next_cells, live;
+    std::vector<uint8_t> counts;    // one row
+    std::vector<uint8_t> column;    // one row: live above + at + below
+
+    uint8_t* at(std::vector<uint8_t>& bytes, int32_t x) {
+        return bytes.data() + static_cast<size_t>(x + 1) * STRIDE + 1;
+    }
+    const uint8_t* at(const std::vector<uint8_t>& bytes, int32_t x) const {
+        return bytes.data() + static_cast<size_t>(x + 1) * STRIDE + 1;
+    }
+
+    static uint64_t load_word(const uint8_t* bytes) {
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        return word;
+    }
+    static void store_word(uint8_t* bytes, uint64_t word) {
+        std::memcpy(bytes, &word, sizeof(word));
+    }
+
+    // 1 in each byte of `word` equal to 1, 0 elsewhere.
+    static uint64_t bytes_equal_one(uint64_t word) {
+        uint64_t diff = word ^ ONES;
+        uint64_t high = ~(((diff & (0x7F * ONES)) + 0x7F * ONES) | diff | (0x7F * ONES));
+        return high >> 7;
+    }
+
+    // High bit set in each byte of `word` that is not zero.
+    static uint64_t bytes_nonzero(uint64_t word) {
+        return (((word & (0x7F * ONES)) + 0x7F * ONES) | word) & (0x80 * ONES);
+    }
+
+    static int64_t sum_bytes(uint64_t word) {
+        uint64_t pairs = (word & 0x00FF00FF00FF00FFULL) + ((word >> 8) & 0x00FF00FF00FF00FFULL);
+        return static_cast<int64_t>((pairs * 0x0001000100010001ULL) >> 48);
+    }
+
+    void mark_live() {
+        const size_t size = cells.size();
+        if (only_one_counts) {
+            for (size_t i = 0; i < size; i += 8) {
+                store_word(live.data() + i, bytes_equal_one(load_word(cells.data() + i)));
+            }
+        } else {
+            for (size_t i = 0; i < size; i++) {
+                live[i] = counted[cells[i]];
+            }
+        }
+    }
+
+    template <bool HASH>
+    void step_rows(GenerationCounters& counters) {
+        mark_live();
+        const uint8_t* lut = table.data();
+        // The frame stays dead whatever the table says about state 0.
+        int64_t population = 0, births = 0, deaths = 0;
+        uint64_t hash_delta = 0;
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            const uint8_t* above = at(live, x - 1) - 1;
+            const uint8_t* mid   = at(live, x) - 1;
+            const uint8_t* below = at(live, x + 1) - 1;
+            // Byte sums of at most 9 never carry into the next byte.
+            for (int32_t i = 0; i < STRIDE; i += 8) {
+                store_word(column.data() + i, load_word(above + i) + load_word(mid + i) + load_word(below + i));
+            }
+            for (int32_t i = 0; i + 8 <= STRIDE - 2; i += 8) {
+                uint64_t sum = load_word(column.data() + i) + load_word(column.data() + i + 1)
+                             + load_word(column.data() + i + 2);
+                store_word(counts.data() + i, sum - load_word(mid + i + 1));
+            }
+
+            const uint8_t* cur = at(cells, x);
+            uint8_t* next = at(next_cells, x);
+            const uint8_t* count = counts.data();
+            for (int32_t y = 0; y < WIDTH; y++) {
+                next[y] = lut[(static_cast<uint32_t>(cur[y]) << 4) | count[y]];
+            }
+            // Bytes past WIDTH are zero in both rows. Counts add up per byte
+            // and are folded into the totals before a byte can overflow.
+            uint64_t now_sum = 0, born_sum = 0, died_sum = 0;
+            for (int32_t y = 0, words = 0; y < WIDTH; y += 8, words++) {
+                if (words == 255) {
+                    population += sum_bytes(now_sum);
+                    births += sum_bytes(born_sum);
+                    deaths += sum_bytes(died_sum);
+                    now_sum = born_sum = died_sum = 0;
+                    words = 0;
+                }
+                uint64_t before = load_word(cur + y), after = load_word(next + y);
+                uint64_t was = bytes_nonzero(before) >> 7, now = bytes_nonzero(after) >> 7;
+                now_sum += now;
+                born_sum += now & ~was;
+                died_sum += was & ~now;
+                if (HASH && before != after) {
+                    for (int32_t i = y; i < std::min(WIDTH, y + 8); i++) {
+                        if (cur[i] != next[i]) {
+                            hash_delta ^= zobrist_key(x, i, cur[i]) ^ zobrist_key(x, i, next[i]);
+                        }
+                    }
+                }
+            }
+            population += sum_bytes(now_sum);
+            births += sum_bytes(born_sum);
+            deaths += sum_bytes(died_sum);
+        }
+        counters.population = population;
+        counters.births = births;
+        counters.deaths = deaths;
+        counters.hash_delta = hash_delta;
+    }
+public:
+    GenerationsEngine()
+        : table(static_cast<size_t>(MAX_STATES) * 16, 0),
+          cells(static_cast<size_t>(HEIGHT + 2) * STRIDE, 0),
+          next_cells(static_cast<size_t>(HEIGHT + 2) * STRIDE, 0),
+          live(static_cast<size_t>(HEIGHT + 2) * STRIDE, 0),
+          counts(STRIDE, 0), column(STRIDE, 0) {
+        set_generations(1u << 3, (1u << 2) | (1u << 3), 2);
+    }
+
+    const char* name() const override { return "generations"; }
+
+    // Generations rule: bit n of `birth_mask` / `survive_mask` means a dead /
+    // live cell with n live neighbours is born / stays; a live cell that does
+    // not stay starts dying, through states 2 to states - 1.
+    void set_generations(uint32_t birth_mask, uint32_t survive_mask, int32_t state_count) {
+        states = std::min(std::max(state_count, 2), MAX_STATES);
+        std::fill(table.begin(), table.end(), 0);
+        for (int32_t n = 0; n <= 8; n++) {
+            table[0 * 16 + n] = (birth_mask >> n) & 1;
+            table[1 * 16 + n] = ((survive_mask >> n) & 1) ? 1 : (states > 2 ? 2 : 0);
+            for (int32_t state = 2; state < states; state++) {
+                table[state * 16 + n] = state + 1 < states ? state + 1 : 0;
+            }
+        }
+        counted.fill(0);
+        counted[1] = 1;
+        only_one_counts = true;
+    }
+
+    // Rulestrings: "B2/S/C3" or "B3/S23" (C defaults to 2), and the older
+    // survive/birth/states form, e.g. "/2/3" or "345/2/4". Returns false and
+    // keeps the current rule if `rule` does not parse.
+    bool set_rule(const std::string& rule) {
+        std::vector<std::string> parts {""};
+        for (char c : rule) {
+            if (c == '/') {
+                parts.emplace_back();
+            } else {
+                parts.back() += c;
+            }
+        }
+        if (parts.size() < 2 || parts.size() > 3) {
+            return false;
+        }
+        bool prefixed = !parts[0].empty() && (parts[0][0] == 'B' || parts[0][0] == 'b');
+        uint32_t masks[2] = {0, 0};
+        int32_t state_count = 2;
+        for (size_t i = 0; i < parts.size(); i++) {
+            std::string part = parts[i];
+            char expected = i == 2 ? 'C' : (prefixed == (i == 0) ? 'B' : 'S');
+            if (prefixed || i == 2) {
+                if (!part.empty() && (part[0] == expected || part[0] == expected + ('a' - 'A'))) {
+                    part.erase(0, 1);
+                } else if (prefixed) {
+                    return false;
+                }
+            }
+            if (i == 2) {
+                bool digits = std::all_of(part.begin(), part.end(), [](char c) { return '0' <= c && c <= '9'; });
+                if (part.empty() || part.size() > 3 || !digits) {
+                    return false;
+                }
+                state_count = std::stoi(part);
+                if (state_count < 2 || state_count > MAX_STATES) {
+                    return false;
+                }
+                continue;
+            }
+            for (char c : part) {
+                if (c < '0' || c > '8') {
+                    return false;
+                }
+                masks[expected == 'B' ? 0 : 1] |= 1u << (c - '0');
+            }
+        }
+        set_generations(masks[0], masks[1], state_count);
+        return true;
+    }
+
+    // Any outer-totalistic rule: start with set_generations() for the state
+    // count, then override single entries and which states count as live.
+    void set_transition(int32_t state, int32_t live_neighbours, int32_t next_state) {
+        if (0 <= state && state < states && 0 <= live_neighbours && live_neighbours <= 8 &&
+            0 <= next_state && next_state < states) {
+            table[state * 16 + live_neighbours] = static_cast<uint8_t>(next_state);
+        }
+    }
+    void set_counted(int32_t state, bool val) {
+        if (0 < state && state < states) {
+            counted[state] = val;
+            only_one_counts = true;
+            for (int32_t other = 0; other < MAX_STATES; other++) {
+                only_one_counts = only_one_counts && counted[other] == (other == 1);
+            }
+        }
+    }
+
+    int32_t get_states() const { return states; }
+    int32_t get_transition(int32_t state, int32_t live_neighbours) const {
+        return table[state * 16 + live_neighbours];
+    }
+
+    void clear() override {
+        std::fill(cells.begin(), cells.end(), 0);
+    }
+
+    int32_t get_id(int32_t x, int32_t y) const override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            return at(cells, x)[y];
+        }
+        return -1;
+    }
+
+    void set_id(int32_t x, int32_t y, int32_t id) override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            at(cells, x)[y] = static_cast<uint8_t>(0 <= id && id < states ? id : 1);
+        }
+    }
+
+    int64_t get_population() const override {
+        int64_t population = 0;
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            const uint8_t* row = at(cells, x);
+            for (int32_t y = 0; y < WIDTH; y++) {
+                population += row[y] != 0;
+            }
+        }
+        return population;
+    }
+
+    void step(GenerationCounters& counters) override {
+        if (this->hashing) {
+            step_rows<true>(counters);
+        } else {
+            step_rows<false>(counters);
+        }
+        std::swap(cells, next_cells);
+    }
+};
+
+#endif // LIFEGAME_GENERATIONSENGINE_H
@@ -0,0 +1,288 @@
+#ifndef LIFEGAME_LARGERTHANLIFEENGINE_H
+#define LIFEGAME_LARGERTHANLIFEENGINE_H
+
+#include <step_engine.h>
+#include <zobrist.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Engine for Larger than Life: range-R neighbourhoods, counts compared with
+// birth and survival intervals, and optional dying states as in Generations
+// (0 dead, 1 alive, 2 to C - 1 dying; only state 1 counts).
+//
+// Counts never loop over the neighbourhood. A box count is four lookups in a
+// summed-area table. A von Neumann (diamond) count slides along the row:
+// moving one column adds the two diagonal edges on the right and drops the
+// two on the left, each one lookup pair in a diagonal prefix sum. Either way
+// a cell costs the same for any R. The board is framed by 2R + 2 dead cells
+// so every lookup stays in range.
+template <int HEIGHT, int WIDTH>
+class LargerThanLifeEngine : public StepEngine<HEIGHT, WIDTH> {
+public:
+    using Field = typename StepEngine<HEIGHT, WIDTH>::Field;
+
+    enum Neighbourhood { BOX, VON_NEUMANN };
+
+    static constexpr int32_t MAX_RANGE = 500;
+    static constexpr int32_t MAX_STATES = 256;
+private:
+    int32_t range {1};
+    int32_t states {2};
+    bool include_center {false};
+    Neighbourhood neighbourhood {BOX};
+    int32_t birth_min {3}, birth_max {3};
+    int32_t survive_min {2}, survive_max {3};
+
+    std::vector<uint8_t> cells, next_cells;
+    // Live flags on the framed board, then its prefix sums.
+    int32_t pad {0}, padded_width {0};
+    std::vector<int32_t> live, sums, anti_sums;
+
+    int32_t& live_at(int32_t r, int32_t c) { return live[static_cast<size_t>(r) * padded_width + c]; }
+
+    void resize() {
+        pad = 2 * range + 2;
+        padded_width = WIDTH + 2 * pad;
+        size_t padded = static_cast<size_t>(HEIGHT + 2 * pad) * padded_width;
+        live.assign(padded, 0);
+        sums.assign(padded, 0);
+        anti_sums.assign(neighbourhood == VON_NEUMANN ? padded : 0, 0);
+    }
+
+    void build_sums() {
+        const int32_t rows = HEIGHT + 2 * pad;
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            const uint8_t* row = cells.data() + static_cast<size_t>(x) * WIDTH;
+            int32_t* out = &live_at(x + pad, pad);
+            for (int32_t y = 0; y < WIDTH; y++) {
+                out[y] = row[y] == 1;
+            }
+        }
+        if (neighbourhood == BOX) {
+            // sums[r][c]: live cells in rows < r and columns < c, framed.
+            for (int32_t r = 1; r < rows; r++) {
+                const int32_t* src = live.data() + static_cast<size_t>(r - 1) * padded_width;
+                const int32_t* above = sums.data() + static_cast<size_t>(r - 1) * padded_width;
+                int32_t* out = sums.data() + static_cast<size_t>(r) * padded_width;
+                int32_t running = 0;
+                for (int32_t c = 1; c < padded_width; c++) {
+                    running += src[c - 1];
+                    out[c] = above[c] + running;
+                }
+            }
+        } else {
+            // sums / anti_sums: running totals down the diagonals towards the
+            // lower right / lower left, inclusive.
+            for (int32_t r = 0; r < rows; r++) {
+                const int32_t* src = live.data() + static_cast<size_t>(r) * padded_width;
+                int32_t* out = sums.data() + static_cast<size_t>(r) * padded_width;
+                int32_t* anti = anti_sums.data() + static_cast<size_t>(r) * padded_width;
+                const int32_t* out_above = out - padded_width;
+                const int32_t* anti_above = anti - padded_width;
+                for (int32_t c = 0; c < padded_width; c++) {
+                    out[c] = src[c] + (r > 0 && c > 0 ? out_above[c - 1] : 0);
+                    anti[c] = src[c] + (r > 0 && c + 1 < padded_width ? anti_above[c + 1] : 0);
+                }
+            }
+        }
+    }
+
+    // Live cells on the diagonal from (r, c) going down-right / down-left,
+    // `len` cells, in framed coordinates.
+    int32_t down_right(int32_t r, int32_t c, int32_t len) const {
+        return sums[static_cast<size_t>(r + len - 1) * padded_width + c + len - 1]
+             - sums[static_cast<size_t>(r - 1) * padded_width + c - 1];
+    }
+    int32_t down_left(int32_t r, int32_t c, int32_t len) const {
+        return anti_sums[static_cast<size_t>(r + len - 1) * padded_width + c - len + 1]
+             - anti_sums[static_cast<size_t>(r - 1) * padded_width + c + 1];
+    }
+
+    uint8_t next_state(uint8_t cell, int32_t count) const {
+        if (cell == 0) {
+            return birth_min <= count && count <= birth_max;
+        }
+        if (cell == 1) {
+            if (survive_min <= count && count <= survive_max) {
+                return 1;
+            }
+            return states > 2 ? 2 : 0;
+        }
+        return cell + 1 < states ? cell + 1 : 0;
+    }
+
+    template <bool HASH, bool DIAMOND>
+    void step_rows(GenerationCounters& counters) {
+        build_sums();
+        int64_t population = 0, births = 0, deaths = 0;
+        uint64_t hash_delta = 0;
+        const int32_t radius = range;
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            const uint8_t* cur = cells.data() + static_cast<size_t>(x) * WIDTH;
+            uint8_t* next = next_cells.data() + static_cast<size_t>(x) * WIDTH;
+            const int32_t* live_row = live.data() + static_cast<size_t>(x + pad) * padded_width + pad;
+            const int32_t cx = x + pad;
+            int32_t diamond = 0; // centred on column -R - 1, all outside the board
+            for (int32_t y = -radius; y < WIDTH; y++) {
+                int32_t count;
+                if (!DIAMOND) {
+                    if (y < 0) {
+                        continue;
+                    }
+                    const int32_t* top = sums.data() + static_cast<size_t>(cx - radius) * padded_width;
+                    const int32_t* bottom = sums.data() + static_cast<size_t>(cx + radius + 1) * padded_width;
+                    const int32_t left = y + pad - radius, right = y + pad + radius + 1;
+                    count = bottom[right] - bottom[left] - top[right] + top[left];
+                } else {
+                    const int32_t cy = y + pad;
+                    diamond += down_right(cx - radius, cy, radius + 1) + down_left(cx + 1, cy + radius - 1, radius)
+                             - down_left(cx - radius, cy - 1, radius + 1) - down_right(cx + 1, cy - radius, radius);
+                    if (y < 0) {
+                        continue;
+                    }
+                    count = diamond;
+                }
+                if (!include_center) {
+                    count -= live_row[y];
+                }
+                uint8_t cell = cur[y];
+                uint8_t result = next_state(cell, count);
+                next[y] = result;
+                population += result != 0;
+                births += cell == 0 && result != 0;
+                deaths += cell != 0 && result == 0;
+                if (HASH && result != cell) {
+                    hash_delta ^= zobrist_key(x, y, cell) ^ zobrist_key(x, y, result);
+                }
+            }
+        }
+        counters.population = population;
+        counters.births = births;
+        counters.deaths = deaths;
+        counters.hash_delta = hash_delta;
+    }
+
+    static bool parse_int(const std::string& text, int32_t& out) {
+        if (text.empty() || text.size() > 6 ||
+            !std::all_of(text.begin(), text.end(), [](char c) { return '0' <= c && c <= '9'; })) {
+            return false;
+        }
+        out = std::atoi(text.c_str());
+        return true;
+    }
+    static bool parse_interval(const std::string& text, int32_t& low, int32_t& high) {
+        size_t dots = text.find("..");
+        if (dots == std::string::npos) {
+            return parse_int(text, low) && parse_int(text, high);
+        }
+        return parse_int(text.substr(0, dots), low) && parse_int(text.substr(dots + 2), high);
+    }
+public:
+    LargerThanLifeEngine()
+        : cells(static_cast<size_t>(HEIGHT) * WIDTH, 0),
+          next_cells(static_cast<size_t>(HEIGHT) * WIDTH, 0) {
+        resize();
+    }
+
+    const char* name() const override { return "larger_than_life"; }
+
+    // Counts include the cell itself when `with_center` is set (LtL's M1).
+    // `state_count` below 3 means two states, as C0 and C2 both do.
+    void set_rule(int32_t new_range, int32_t b_min, int32_t b_max, int32_t s_min, int32_t s_max,
+                  int32_t state_count = 2, bool with_center = false, Neighbourhood kind = BOX) {
+        range = std::min(std::max(new_range, 1), MAX_RANGE);
+        birth_min = b_min;
+        birth_max = b_max;
+        survive_min = s_min;
+        survive_max = s_max;
+        states = std::min(std::max(state_count, 2), MAX_STATES);
+        include_center = with_center;
+        neighbourhood = kind;
+        resize();
+    }
+
+    // LtL rulestring as Golly writes it, e.g. Bosco's "R5,C0,M1,S34..58,B34..45,NM".
+    // N is M (box) or N (von Neumann); it and C and M may be left out.
+    // Returns false and keeps the current rule if `rule` does not parse.
+    bool set_rule(const std::string& rule) {
+        int32_t new_range = -1, state_count = 0, center = 0;
+        int32_t b_min = -1, b_max = -1, s_min = -1, s_max = -1;
+        Neighbourhood kind = BOX;
+        size_t start = 0;
+        while (start <= rule.size()) {
+            size_t comma = rule.find(',', start);
+            std::string part = rule.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+            start = comma == std::string::npos ? rule.size() + 1 : comma + 1;
+            if (part.empty()) {
+                return false;
+            }
+            std::string value = part.substr(1);
+            bool ok = false;
+            switch (part[0]) {
+                case 'R': case 'r': ok = parse_int(value, new_range); break;
+                case 'C': case 'c': ok = parse_int(value, state_count); break;
+                case 'M': case 'm': ok = parse_int(value, center) && center <= 1; break;
+                case 'S': case 's': ok = parse_interval(value, s_min, s_max); break;
+                case 'B': case 'b': ok = parse_interval(value, b_min, b_max); break;
+                case 'N': case 'n':
+                    ok = value == "M" || value == "m" || value == "N" || value == "n";
+                    kind = (value == "N" || value == "n") ? VON_NEUMANN : BOX;
+                    break;
+                default: break;
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+        if (new_range < 1 || new_range > MAX_RANGE || b_min < 0 || s_min < 0 || state_count > MAX_STATES) {
+            return false;
+        }
+        set_rule(new_range, b_min, b_max, s_min, s_max, state_count, center == 1, kind);
+        return true;
+    }
+
+    int32_t get_range() const { return range; }
+    int32_t get_states() const { return states; }
+    Neighbourhood get_neighbourhood() const { return neighbourhood; }
+
+    void clear() override {
+        std::fill(cells.begin(), cells.end(), 0);
+    }
+
+    int32_t get_id(int32_t x, int32_t y) const override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            return cells[static_cast<size_t>(x) * WIDTH + y];
+        }
+        return -1;
+    }
+
+    void set_id(int32_t x, int32_t y, int32_t id) override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            cells[static_cast<size_t>(x) * WIDTH + y] = static_cast<uint8_t>(0 <= id && id < states ? id : 1);
+        }
+    }
+
+    int64_t get_population() const override {
+        int64_t population = 0;
+        for (uint8_t cell : cells) {
+            population += cell != 0;
+        }
+        return population;
+    }
+
+    void step(GenerationCounters& counters) override {
+        const bool diamond = neighbourhood == VON_NEUMANN;
+        if (this->hashing) {
+            diamond ? step_rows<true, true>(counters) : step_rows<true, false>(counters);
+        } else {
+            diamond ? step_rows<false, true>(counters) : step_rows<false, false>(counters);
+        }
+        std::swap(cells, next_cells);
+    }
+};
+
+#endif // LIFEGAME_LARGERTHANLIFEENGINE_H
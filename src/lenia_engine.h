@@ -0,0 +1,296 @@
+#ifndef LIFEGAME_LENIAENGINE_H
+#define LIFEGAME_LENIAENGINE_H
+
+#include <fft.h>
+#include <life_trace.h>
+#include <step_engine.h>
+#include <thread_pool.h>
+#include <zobrist.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Engine for Lenia: cells hold a value in [0, 1], the potential of a cell is
+// its neighbourhood weighted by a smooth ring-shaped kernel of radius R, and
+// each step adds dt * G(potential) and clamps, with the growth function
+// G(u) = 2 exp(-(u - mu)^2 / (2 sigma^2)) - 1. The defaults are Orbium's.
+//
+// The potential is a convolution done in the frequency domain: the board is
+// zero-padded to a power of two at least R past it on each axis, so nothing
+// wraps and cells outside the board stay dead, and transformed as real data
+// (two rows per complex FFT, half the columns of spectrum). The kernel's
+// spectrum is worked out once per kernel and kept. Row and column passes are
+// spread over the thread pool.
+//
+// Ids are values quantised to 0..LEVELS, so LifeGame can show the board with
+// Rules::ramp_colors_judge; population counts cells with a nonzero id.
+template <int HEIGHT, int WIDTH>
+class LeniaEngine : public StepEngine<HEIGHT, WIDTH> {
+public:
+    using Field = typename StepEngine<HEIGHT, WIDTH>::Field;
+    using Complex = Fft::Complex;
+
+    static constexpr int32_t LEVELS = 255;
+    static constexpr int32_t MAX_RADIUS = 128;
+    // Spectrum columns gathered and transformed per column-pass task.
+    static constexpr size_t COLUMN_BLOCK = 8;
+private:
+    int32_t radius {13};
+    std::vector<float> peaks {1.0f};
+    float mu {0.15f}, sigma {0.015f}, dt {0.1f};
+
+    std::vector<float> cells;
+    size_t rows {0}, cols {0}, half {0};   // padded size; half = cols / 2 + 1
+    Fft row_fft, col_fft;
+    std::vector<Complex> spectrum, kernel_spectrum;
+    bool kernel_stale {true};
+    std::vector<GenerationCounters> pair_counters;
+    ThreadPool pool;
+
+    static int32_t quantise(float value) {
+        return static_cast<int32_t>(value * LEVELS + 0.5f);
+    }
+
+    // Smooth bump on (0, 1), peaking at 1/2; each kernel shell is one bump.
+    static double core(double r) {
+        return 0 < r && r < 1 ? std::exp(4.0 - 1.0 / (r * (1.0 - r))) : 0.0;
+    }
+
+    // Row pass of the forward transform: rows [0, src_rows) of `src`, each
+    // src_cols wide, zero beyond, into rows of `spectrum` half wide.
+    void forward_rows(const float* src, size_t src_rows, size_t src_cols, std::vector<Complex>& out) {
+        const size_t pairs = (src_rows + 1) / 2;
+        pool.parallel_for(pairs, [&](size_t p) {
+            std::vector<Complex> z(cols, Complex(0, 0));
+            const size_t r = 2 * p;
+            const float* first = src + r * src_cols;
+            const float* second = r + 1 < src_rows ? first + src_cols : nullptr;
+            for (size_t j = 0; j < src_cols; j++) {
+                z[j] = Complex(first[j], second != nullptr ? second[j] : 0.0f);
+            }
+            row_fft.forward(z.data());
+            // z = fft(a + ib): A[k] = (z[k] + conj z[-k]) / 2 and
+            // B[k] = (z[k] - conj z[-k]) / 2i.
+            Complex* a = out.data() + r * half;
+            Complex* b = a + half;
+            for (size_t k = 0; k < half; k++) {
+                Complex zk = z[k], zm = std::conj(z[(cols - k) & (cols - 1)]);
+                Complex sum = zk + zm, diff = zk - zm;
+                a[k] = Complex(0.5f * sum.real(), 0.5f * sum.imag());
+                b[k] = Complex(0.5f * diff.imag(), -0.5f * diff.real());
+            }
+        });
+        const size_t filled = std::min(rows, 2 * pairs);
+        std::fill(out.begin() + filled * half, out.end(), Complex(0, 0));
+    }
+
+    // Column pass: forward transform down every spectrum column and, with
+    // CONVOLVE, multiply by the kernel and transform back; only the board's
+    // rows are written back then, since the rest are never read.
+    template <bool CONVOLVE>
+    void columns(std::vector<Complex>& data) {
+        const size_t blocks = (half + COLUMN_BLOCK - 1) / COLUMN_BLOCK;
+        pool.parallel_for(blocks, [&](size_t block) {
+            const size_t k_begin = block * COLUMN_BLOCK;
+            const size_t width = std::min(COLUMN_BLOCK, half - k_begin);
+            std::vector<Complex> buffer(width * rows);
+            for (size_t r = 0; r < rows; r++) {
+                const Complex* row = data.data() + r * half + k_begin;
+                for (size_t k = 0; k < width; k++) {
+                    buffer[k * rows + r] = row[k];
+                }
+            }
+            for (size_t k = 0; k < width; k++) {
+                Complex* column = buffer.data() + k * rows;
+                col_fft.forward(column);
+                if (CONVOLVE) {
+                    for (size_t r = 0; r < rows; r++) {
+                        column[r] = Fft::multiply(column[r], kernel_spectrum[r * half + k_begin + k]);
+                    }
+                    col_fft.inverse(column);
+                }
+            }
+            const size_t board_rows = std::min(rows, static_cast<size_t>(HEIGHT + 1) / 2 * 2);
+            const size_t rows_back = CONVOLVE ? board_rows : rows;
+            for (size_t r = 0; r < rows_back; r++) {
+                Complex* row = data.data() + r * half + k_begin;
+                for (size_t k = 0; k < width; k++) {
+                    row[k] = buffer[k * rows + r];
+                }
+            }
+        });
+    }
+
+    void build_kernel() {
+        rows = Fft::round_up(static_cast<size_t>(HEIGHT + radius));
+        cols = Fft::round_up(static_cast<size_t>(WIDTH + radius));
+        half = cols / 2 + 1;
+        row_fft = Fft(cols);
+        col_fft = Fft(rows);
+        spectrum.assign(rows * half, Complex(0, 0));
+        kernel_spectrum.assign(rows * half, Complex(0, 0));
+
+        // Offsets wrap around the padded torus; the padding keeps the wrapped
+        // parts off the board.
+        std::vector<double> weights(rows * cols, 0.0);
+        double total = 0;
+        const double shells = static_cast<double>(peaks.size());
+        for (int32_t dx = -radius; dx <= radius; dx++) {
+            for (int32_t dy = -radius; dy <= radius; dy++) {
+                double distance = std::sqrt(static_cast<double>(dx * dx + dy * dy)) / radius;
+                if (distance >= 1) {
+                    continue;
+                }
+                double shell = shells * distance;
+                size_t index = static_cast<size_t>(shell);
+                double weight = peaks[index] * core(shell - index);
+                weights[((dx + rows) & (rows - 1)) * cols + ((dy + cols) & (cols - 1))] = weight;
+                total += weight;
+            }
+        }
+        // Normalised to sum 1, with the 1 / (rows * cols) of the inverse
+        // transform folded in.
+        const double scale = total > 0 ? 1.0 / (total * static_cast<double>(rows * cols)) : 0.0;
+        std::vector<float> scaled(weights.size());
+        for (size_t i = 0; i < weights.size(); i++) {
+            scaled[i] = static_cast<float>(weights[i] * scale);
+        }
+        forward_rows(scaled.data(), rows, cols, kernel_spectrum);
+        columns<false>(kernel_spectrum);
+        pair_counters.assign((HEIGHT + 1) / 2, GenerationCounters {});
+        kernel_stale = false;
+    }
+
+    // Row pass of the inverse transform, two rows per complex FFT, and the
+    // growth update of those rows in place.
+    template <bool HASH>
+    void update_rows() {
+        const float inv_two_sigma_sq = 1.0f / (2.0f * sigma * sigma);
+        pool.parallel_for(pair_counters.size(), [&](size_t p) {
+            std::vector<Complex> z(cols);
+            const size_t r = 2 * p;
+            const Complex* a = spectrum.data() + r * half;
+            const Complex* b = a + half;
+            // z = A + iB over the full row; the upper half mirrors the lower.
+            for (size_t k = 0; k < half; k++) {
+                z[k] = Complex(a[k].real() - b[k].imag(), a[k].imag() + b[k].real());
+            }
+            for (size_t k = half; k < cols; k++) {
+                const Complex ak = a[cols - k], bk = b[cols - k];
+                z[k] = Complex(ak.real() + bk.imag(), bk.real() - ak.imag());
+            }
+            row_fft.inverse(z.data());
+
+            GenerationCounters& counters = pair_counters[p];
+            counters = GenerationCounters {};
+            for (size_t i = 0; i < 2 && r + i < static_cast<size_t>(HEIGHT); i++) {
+                const int32_t x = static_cast<int32_t>(r + i);
+                float* row = cells.data() + (r + i) * WIDTH;
+                for (int32_t y = 0; y < WIDTH; y++) {
+                    const float potential = i == 0 ? z[y].real() : z[y].imag();
+                    const float offset = potential - mu;
+                    const float growth = 2.0f * std::exp(-offset * offset * inv_two_sigma_sq) - 1.0f;
+                    const float before = row[y];
+                    const float after = std::min(1.0f, std::max(0.0f, before + dt * growth));
+                    row[y] = after;
+                    const int32_t was = quantise(before), now = quantise(after);
+                    counters.population += now != 0;
+                    counters.births += was == 0 && now != 0;
+                    counters.deaths += was != 0 && now == 0;
+                    if (HASH && was != now) {
+                        counters.hash_delta ^= zobrist_key(x, y, was) ^ zobrist_key(x, y, now);
+                    }
+                }
+            }
+        });
+    }
+public:
+    // `threads` counts the calling thread; 0 means one per hardware thread.
+    explicit LeniaEngine(size_t threads = 0)
+        : cells(static_cast<size_t>(HEIGHT) * WIDTH, 0.0f), pool(threads) {}
+
+    const char* name() const override { return "lenia"; }
+
+    // Kernel of `new_radius` cells made of one shell per entry of
+    // `shell_peaks`, each a smooth bump scaled by its peak.
+    void set_kernel(int32_t new_radius, const std::vector<float>& shell_peaks = {1.0f}) {
+        radius = std::min(std::max(new_radius, 1), MAX_RADIUS);
+        peaks = shell_peaks.empty() ? std::vector<float> {1.0f} : shell_peaks;
+        kernel_stale = true;
+    }
+
+    void set_growth(float new_mu, float new_sigma) {
+        mu = new_mu;
+        sigma = std::max(new_sigma, 1e-6f);
+    }
+
+    void set_time_step(float new_dt) { dt = new_dt; }
+
+    int32_t get_radius() const { return radius; }
+    const std::vector<float>& get_peaks() const { return peaks; }
+    float get_mu() const { return mu; }
+    float get_sigma() const { return sigma; }
+    float get_time_step() const { return dt; }
+
+    void clear() override {
+        std::fill(cells.begin(), cells.end(), 0.0f);
+    }
+
+    float get_value(int32_t x, int32_t y) const {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            return cells[static_cast<size_t>(x) * WIDTH + y];
+        }
+        return 0.0f;
+    }
+
+    void set_value(int32_t x, int32_t y, float value) {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            cells[static_cast<size_t>(x) * WIDTH + y] = std::min(1.0f, std::max(0.0f, value));
+        }
+    }
+
+    int32_t get_id(int32_t x, int32_t y) const override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            return quantise(cells[static_cast<size_t>(x) * WIDTH + y]);
+        }
+        return -1;
+    }
+
+    // Ids map linearly onto [0, 1]; out-of-range ids are clamped.
+    void set_id(int32_t x, int32_t y, int32_t id) override {
+        set_value(x, y, static_cast<float>(id) / LEVELS);
+    }
+
+    int64_t get_population() const override {
+        int64_t population = 0;
+        for (float cell : cells) {
+            population += quantise(cell) != 0;
+        }
+        return population;
+    }
+
+    void step(GenerationCounters& counters) override {
+        LIFE_TRACE_SCOPE("lenia_step");
+        if (kernel_stale) {
+            build_kernel();
+        }
+        forward_rows(cells.data(), HEIGHT, WIDTH, spectrum);
+        columns<true>(spectrum);
+        if (this->hashing) {
+            update_rows<true>();
+        } else {
+            update_rows<false>();
+        }
+        counters = GenerationCounters {};
+        for (const GenerationCounters& pair : pair_counters) {
+            counters.population += pair.population;
+            counters.births += pair.births;
+            counters.deaths += pair.deaths;
+            counters.hash_delta ^= pair.hash_delta;
+        }
+    }
+};
+
+#endif // LIFEGAME_LENIAENGINE_H
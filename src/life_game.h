@@ -4,6 +4,16 @@
 #include <SFML/Window.hpp>
 #include <SFML/Graphics.hpp>
 #include <SFML/System.hpp>
+#include <adaptive_engine.h>
+#include <arena.h>
+#include <cycle_detector.h>
+#include <edit_queue.h>
+#include <generation_buffers.h>
+#include <life_stats.h>
+#include <life_trace.h>
+#include <step_engine.h>
+#include <zobrist.h>
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <initializer_list>
@@ -16,18 +26,138 @@ class LifeGame {
 public:
     class Rules;
     Rules* rules;
+    using Field = std::array< std::array<int32_t, WIDTH>, HEIGHT >;
+    using FieldView = typename GenerationBuffers<Field>::View;
 private:
-    std::array< std::array<int32_t, WIDTH>, HEIGHT > field {}, prev_field {};
+    // The dense board, generation by generation: a step writes a free buffer
+    // and publishes it, and views handed out by get_view() stay put.
+    GenerationBuffers<Field> fields {};
     sf::RenderWindow window {};
     
     void (*judge_field) (const std::array< std::array<int32_t, WIDTH>, HEIGHT >&,
                                std::array< std::array<int32_t, WIDTH>, HEIGHT >&)
      = nullptr;
 
+    void (*judge_field_counted) (const std::array< std::array<int32_t, WIDTH>, HEIGHT >&,
+                                       std::array< std::array<int32_t, WIDTH>, HEIGHT >&,
+                                       GenerationCounters&)
+     = nullptr;
+
+    // Counted kernel that also reports the hash change, for cycle detection.
+    void (*judge_field_hashed) (const std::array< std::array<int32_t, WIDTH>, HEIGHT >&,
+                                      std::array< std::array<int32_t, WIDTH>, HEIGHT >&,
+                                      GenerationCounters&)
+     = nullptr;
+
     sf::Color (*judge_color)(int32_t id)
      = nullptr;
 
-    int32_t& get_cell_mouse_points_to() {
+    // While an engine is set it holds the live state and the current buffer
+    // is only a copy for drawing, refreshed lazily after steps into a fresh
+    // buffer so that views are left alone.
+    StepEngine<HEIGHT, WIDTH>* engine = nullptr;
+    bool field_stale {false};
+    std::unique_ptr< AdaptiveEngine<HEIGHT, WIDTH> > adaptive;
+
+    void sync_field() {
+        if (field_stale) {
+            engine->store(fields.acquire_next());
+            fields.publish(generation);
+            field_stale = false;
+        }
+    }
+
+    using Detector = CycleDetector< std::array< std::array<int32_t, WIDTH>, HEIGHT > >;
+
+    bool cycle_detection {false};
+    uint64_t board_hash {0};
+    Detector detector {};
+
+    bool stats_enabled {false};
+    uint64_t generation {0};
+    double last_render_ms {0};
+    GenerationStatsRing<> stats {};
+
+    using StatsClock = std::chrono::steady_clock;
+
+    static double elapsed_ms(StatsClock::time_point since) {
+        return std::chrono::duration<double, std::milli>(StatsClock::now() - since).count();
+    }
+
+    // What a stats record needs from before the step; only filled in while
+    // stats are enabled.
+    struct RecordStart {
+        StatsClock::time_point begin;
+        uint64_t allocations {0};
+    };
+
+    RecordStart begin_record() {
+        RecordStart start;
+        if (stats_enabled) {
+            start.begin = StatsClock::now();
+            start.allocations = Arena::global().get_stats().allocations;
+        }
+        return start;
+    }
+
+    // The record of the step that began at `start`, from generation
+    // `generation`, which the caller has not advanced yet.
+    void push_record(const RecordStart& start, const GenerationCounters& counters) {
+        if (!stats_enabled) {
+            return;
+        }
+        GenerationRecord record;
+        record.generation = generation;
+        record.render_ms = last_render_ms;
+        record.step_ms = elapsed_ms(start.begin);
+        record.population = counters.population;
+        record.births = counters.births;
+        record.deaths = counters.deaths;
+        Arena::Stats arena = Arena::global().get_stats();
+        record.allocations = arena.allocations - start.allocations;
+        record.arena_bytes = arena.bytes_in_use;
+        record.cache_hits = counters.cache_hits;
+        record.cache_misses = counters.cache_misses;
+        stats.push(record);
+    }
+
+    // Edits posted from any thread, applied by the stepping thread between
+    // generations.
+    EditQueue edits {};
+    int32_t paint_color {1};
+
+    void apply_edit(const EditCommand& command) {
+        switch (command.kind) {
+            case EditCommand::SET_CELL:
+                set_id(command.x, command.y, command.id);
+                break;
+            case EditCommand::FILL_RECT:
+                for (int32_t x = std::max(command.x, 0); x < std::min(command.x + command.height, HEIGHT); x++) {
+                    for (int32_t y = std::max(command.y, 0); y < std::min(command.y + command.width, WIDTH); y++) {
+                        set_id(x, y, command.id);
+                    }
+                }
+                break;
+            case EditCommand::STAMP:
+                for (const std::pair<int32_t, int32_t>& cell : command.cells) {
+                    set_id(command.x + cell.first, command.y + cell.second, command.id);
+                }
+                break;
+        }
+    }
+
+    // Everything posted so far, in posting order per thread. An empty queue
+    // costs two loads.
+    void apply_edits() {
+        EditCommand command;
+        while (edits.pop(command)) {
+            LIFE_TRACE_SCOPE("apply_edit");
+            apply_edit(command);
+        }
+    }
+
+    // The cell under the mouse, if there is one.
+    bool get_cell_mouse_points_to(int32_t& x_cell, int32_t& y_cell) {
         sf::Vector2i pos = sf::Mouse::getPosition(window);
         float x, y;
         x = (pos.y - rules->get_up_indent())   / rules->get_height_of_cell();
@@ -36,9 +166,18 @@ private:
         int32_t y_int = static_cast<int>(y);
         if (x < 0 || x > HEIGHT || x - x_int < Rules::_EPS || x - x_int > 1 - Rules::_EPS ||
             y < 0 || y > WIDTH  || y - y_int < Rules::_EPS || y - y_int > 1 - Rules::_EPS) {
-                return rules->_NOTCELL;
+                return false;
+        }
+        x_cell = x_int;
+        y_cell = y_int;
+        return true;
+    }
+
+    void paint_cell_mouse_points_to() {
+        int32_t x, y;
+        if (get_cell_mouse_points_to(x, y)) {
+            post_edit(EditCommand::set_cell(x, y, paint_color));
         }
-        return field[ static_cast<int>(x) ][ static_cast<int>(y) ];
     }
 
     sf::Time get_sleep_time_milliseconds(int speed) {
@@ -60,9 +199,90 @@ private:
         return 2.f * rules->get_up_indent() + height * rules->get_height_of_cell();
     }
 
+public:
+    // Advances one generation, applying posted edits first.
     void make_step() {
-        judge_field(field, prev_field);
-        std::swap(prev_field, field);
+        LIFE_TRACE_SCOPE("make_step");
+        apply_edits();
+        RecordStart record_start = begin_record();
+        GenerationCounters counters;
+        if (engine != nullptr) {
+            engine->step(counters);
+            field_stale = true;
+        } else {
+            const Field& field = fields.get_current();
+            Field& next_field = fields.acquire_next();
+            if (cycle_detection && judge_field_hashed != nullptr) {
+                judge_field_hashed(field, next_field, counters);
+            } else if (judge_field_counted != nullptr && (stats_enabled || cycle_detection)) {
+                judge_field_counted(field, next_field, counters);
+                if (cycle_detection) {
+                    counters.hash_delta = zobrist_delta<HEIGHT, WIDTH>(field, next_field);
+                }
+            } else {
+                judge_field(field, next_field);
+                // The detector needs the population to tell extinction from
+                // a still life, so find it along with the hash.
+                if (cycle_detection) {
+                    counters_between<HEIGHT, WIDTH>(field, next_field, counters);
+                } else {
+                    counters.population = counters.births = counters.deaths = -1;
+                }
+            }
+            fields.publish(generation + 1);
+        }
+        push_record(record_start, counters);
+        generation++;
+        if (cycle_detection) {
+            board_hash ^= counters.hash_delta;
+            detector.observe(generation, board_hash, counters.population,
+                             [this](std::array< std::array<int32_t, WIDTH>, HEIGHT >& out) {
+                                 sync_field();
+                                 out = fields.get_current();
+                             });
+        }
+    }
+
+    // Advances `generations` generations in one call to the engine's
+    // make_step(), so TiledEngine can block them in time. Cycle detection
+    // and stats have to see every generation, so with either on, or without
+    // an engine, this is make_step() repeated.
+    void make_step(int32_t generations) {
+        if (engine == nullptr || cycle_detection || stats_enabled) {
+            for (int32_t i = 0; i < generations; i++) {
+                make_step();
+            }
+            return;
+        }
+        LIFE_TRACE_SCOPE("make_step");
+        apply_edits();
+        GenerationCounters counters;
+        engine->make_step(generations, counters);
+        field_stale = true;
+        generation += generations;
+    }
+private:
+
+    // Key of a cell as the hash sees it; engines only know alive or dead.
+    uint64_t cell_key(int32_t x, int32_t y, int32_t id) {
+        return zobrist_key(x, y, engine != nullptr ? id != 0 : id);
+    }
+
+    void rehash() {
+        sync_field();
+        board_hash = 0;
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            for (int32_t y = 0; y < WIDTH; y++) {
+                board_hash ^= cell_key(x, y, fields.get_current()[x][y]);
+            }
+        }
+        detector.reset();
+    }
+
+    bool settled() {
+        typename Detector::Kind kind = detector.get_result().kind;
+        return cycle_detection && (kind == Detector::EXTINCT ||
+                                   kind == Detector::STILL_LIFE);
     }
 
     sf::Vector2f get_size_of_cell() {
@@ -70,31 +290,171 @@ private:
     }
 
     void draw_field() {
+        LIFE_TRACE_SCOPE("draw_field");
+        StatsClock::time_point begin = StatsClock::now();
+        FieldView view = get_view();
         for (int32_t x = 0; x < HEIGHT; x++) {
             for (int32_t y = 0; y < WIDTH; y++) {
                 sf::RectangleShape cell_to_draw(get_size_of_cell());
                 cell_to_draw.setOutlineThickness(1);
                 cell_to_draw.setOutlineColor(sf::Color::Black);
-                cell_to_draw.setFillColor( judge_color(get_id(x, y)) );
+                cell_to_draw.setFillColor( judge_color((*view)[x][y]) );
                 sf::Vector2f cords = get_left_up_corner_pos(x, y);
                 std::swap(cords.x, cords.y);
                 cell_to_draw.setPosition(cords);
                 window.draw(cell_to_draw);
             }
         }
+        if (stats_enabled) {
+            last_render_ms = elapsed_ms(begin);
+        }
     }
 public:
     void set_judge_field_function(void (*judge_func) (const std::array< std::array<int32_t, WIDTH>, HEIGHT >&,
                                                             std::array< std::array<int32_t, WIDTH>, HEIGHT >&)) {
         judge_field = judge_func;
+        judge_field_counted = nullptr;
+        judge_field_hashed = nullptr;
+    }
+    // Kernel that also reports population, births and deaths of the step it
+    // makes, and optionally one that reports its hash change on top.
+    void set_judge_field_function(void (*judge_func) (const std::array< std::array<int32_t, WIDTH>, HEIGHT >&,
+                                                            std::array< std::array<int32_t, WIDTH>, HEIGHT >&),
+                                  void (*judge_counted_func) (const std::array< std::array<int32_t, WIDTH>, HEIGHT >&,
+                                                                    std::array< std::array<int32_t, WIDTH>, HEIGHT >&,
+                                                                    GenerationCounters&),
+                                  void (*judge_hashed_func) (const std::array< std::array<int32_t, WIDTH>, HEIGHT >&,
+                                                                   std::array< std::array<int32_t, WIDTH>, HEIGHT >&,
+                                                                   GenerationCounters&) = nullptr) {
+        judge_field = judge_func;
+        judge_field_counted = judge_counted_func;
+        judge_field_hashed = judge_hashed_func;
     }
     void set_judge_color_function(sf::Color (*judge_func)(int32_t id)) {
         judge_color = judge_func;
     }
 
+    // Hands the board to `new_engine` (not owned), or back to the judge
+    // function with nullptr. The state moves over through load()/store().
+    void set_engine(StepEngine<HEIGHT, WIDTH>* new_engine) {
+        sync_field();
+        engine = new_engine;
+        if (engine != nullptr) {
+            engine->load(fields.get_current());
+            engine->set_hashing(cycle_detection);
+        }
+        if (cycle_detection) {
+            rehash();
+        }
+    }
+    StepEngine<HEIGHT, WIDTH>* get_engine()  { return engine; }
+
+    // Lets the board move between the bitwise, tiled and sparse engines as
+    // its density and activity change. Only for the standard Life rule.
+    void set_adaptive_engine(bool enabled, int32_t sample_every = 64) {
+        if (!enabled) {
+            if (engine != nullptr && engine == adaptive.get()) {
+                set_engine(nullptr);
+            }
+            return;
+        }
+        if (!adaptive) {
+            adaptive = std::make_unique< AdaptiveEngine<HEIGHT, WIDTH> >();
+        }
+        adaptive->set_sample_every(sample_every);
+        set_engine(adaptive.get());
+    }
+    AdaptiveEngine<HEIGHT, WIDTH>* get_adaptive_engine() { return adaptive.get(); }
+
+    // Steps without a window, e.g. for batch runs. Once cycle detection has
+    // confirmed a cycle of period P, only the remainder modulo P is actually
+    // stepped and the rest is skipped. With stats enabled every generation
+    // still gets its own record. Returns the generations computed.
+    uint64_t run(uint64_t generations) {
+        uint64_t target = generation + generations;
+        uint64_t computed = 0;
+        if (!cycle_detection) {
+            while (generation < target) {
+                int32_t chunk = static_cast<int32_t>(std::min<uint64_t>(target - generation, INT32_MAX));
+                make_step(chunk);
+                computed += chunk;
+            }
+            return computed;
+        }
+        while (generation < target) {
+            const typename Detector::Result& cycle = detector.get_result();
+            if (cycle_detection && cycle.kind != Detector::NONE) {
+                uint64_t remaining = target - generation;
+                uint64_t skipped = remaining - remaining % cycle.period;
+                generation += skipped;
+                if (remaining % cycle.period == 0) {
+                    break;
+                }
+            }
+            make_step();
+            computed++;
+        }
+        return computed;
+    }
+
+    // Steps until the board dies out, freezes or cycles, at most
+    // `max_generations` times. Returns whether it settled.
+    bool run_until_settled(uint64_t max_generations) {
+        for (uint64_t i = 0; i < max_generations; i++) {
+            if (detector.get_result().kind != Detector::NONE) {
+                return true;
+            }
+            make_step();
+        }
+        return detector.get_result().kind != Detector::NONE;
+    }
+
+    // Tracks an incremental board hash and watches it for extinction, still
+    // lifes and cycles up to `max_period`. start() stops stepping boards that
+    // died out or froze, run() fast-forwards through confirmed cycles.
+    void set_cycle_detection(bool enabled, int32_t max_period = 64) {
+        cycle_detection = enabled;
+        detector = Detector(max_period);
+        if (engine != nullptr) {
+            engine->set_hashing(enabled);
+        }
+        if (enabled) {
+            rehash();
+        }
+    }
+    const typename Detector::Result& get_cycle_result() { return detector.get_result(); }
+    uint64_t get_board_hash()                                              { return board_hash;             }
+
+    // Per-generation records are only collected while stats are enabled.
+    void set_stats_enabled(bool val)    { stats_enabled = val;     }
+    bool get_stats_enabled()            { return stats_enabled;    }
+    uint64_t get_generation()           { return generation;       }
+    GenerationStatsRing<>& get_stats()  { return stats;            }
+
+    // Read-only view of the board as of the last generation. Take it on the
+    // thread that steps; it can then be read on any thread and keeps showing
+    // that generation while later ones are computed, until released.
+    FieldView get_view() {
+        sync_field();
+        return fields.read();
+    }
+
+    void output_stats(const char* file_name, bool json = false) {
+        LIFE_TRACE_SCOPE("output_stats");
+        std::vector<GenerationRecord> records;
+        stats.drain(records);
+        std::ofstream out(file_name);
+        if (json) {
+            GenerationStatsRing<>::write_json(out, records);
+        } else {
+            GenerationStatsRing<>::write_csv(out, records);
+        }
+    }
+
     int32_t get_id(int32_t x, int32_t y) {
+        sync_field();
         if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
-            return field[x][y];
+            return fields.get_current()[x][y];
         } else {
             return -1;        
         }
@@ -107,8 +467,17 @@ public:
     }
 
     void set_id(int32_t x, int32_t y, int32_t id) {
+        sync_field();
         if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            Field& field = fields.edit_current();
+            if (cycle_detection && field[x][y] != id) {
+                board_hash ^= cell_key(x, y, field[x][y]) ^ cell_key(x, y, id);
+                detector.reset();
+            }
             field[x][y] = id;
+            if (engine != nullptr) {
+                engine->set_id(x, y, id);
+            }
         }
     }
     void set_id(std::pair<int32_t, int32_t> cords, int32_t id) {
@@ -118,6 +487,13 @@ public:
         set_id(cords.x, cords.x, id);
     }
 
+    // Queues an edit; safe on any thread, also while another one is
+    // stepping. Edits are applied whole, before the next generation is
+    // computed, and cells outside the board are ignored.
+    void post_edit(EditCommand command) {
+        edits.push(std::move(command));
+    }
+
 class Rules {
 private:    
     int32_t MIN_POSSIBLE_FPS   {1};
@@ -155,9 +531,32 @@ public:
 
     static void life_game_judge(const std::array< std::array<int32_t, WIDTH>, HEIGHT >& arr,
                                       std::array< std::array<int32_t, WIDTH>, HEIGHT >& res) {
+        GenerationCounters unused;
+        life_game_judge_impl<false, false>(arr, res, unused);
+    }
+
+    static void life_game_judge_counted(const std::array< std::array<int32_t, WIDTH>, HEIGHT >& arr,
+                                              std::array< std::array<int32_t, WIDTH>, HEIGHT >& res,
+                                              GenerationCounters& counters) {
+        life_game_judge_impl<true, false>(arr, res, counters);
+    }
+
+    // Counted and with the hash change, for cycle detection.
+    static void life_game_judge_hashed(const std::array< std::array<int32_t, WIDTH>, HEIGHT >& arr,
+                                             std::array< std::array<int32_t, WIDTH>, HEIGHT >& res,
+                                             GenerationCounters& counters) {
+        life_game_judge_impl<true, true>(arr, res, counters);
+    }
+
+    template <bool COUNT, bool HASH>
+    static void life_game_judge_impl(const std::array< std::array<int32_t, WIDTH>, HEIGHT >& arr,
+                                           std::array< std::array<int32_t, WIDTH>, HEIGHT >& res,
+                                           GenerationCounters& counters) {
         static int32_t dx[] = {0, 0, 1, 1, 1, -1, -1, -1};
         static int32_t dy[] = {-1, 1, -1, 0, 1, -1, 0, 1};
 
+        int64_t population = 0, births = 0, deaths = 0;
+        uint64_t hash_delta = 0;
         for (int x = 0; x < HEIGHT; x++) {
             for (int y = 0; y < WIDTH; y++) {
                 int32_t cnt_alive = 0;
@@ -169,26 +568,89 @@ public:
                         cnt_alive += arr[nx][ny];
                     }
                 }
-                if (arr[x][y] == 0) {
-                    res[x][y] = cnt_alive == 3;
+                int32_t cell = arr[x][y];
+                int32_t next;
+                if (cell == 0) {
+                    next = cnt_alive == 3;
                 } else {
-                    res[x][y] = cnt_alive == 2 || cnt_alive == 3;
+                    next = cnt_alive == 2 || cnt_alive == 3;
+                }
+                res[x][y] = next;
+            }
+            // Counted per row after the fact, so the loop above is the plain
+            // kernel's. With cells 0 or 1, births - deaths is the change in
+            // population and births + deaths the number of cells that flipped.
+            if (COUNT) {
+                int32_t now = 0, after = 0, flipped = 0;
+                for (int y = 0; y < WIDTH; y++) {
+                    now += arr[x][y];
+                    after += res[x][y];
+                    flipped += arr[x][y] ^ res[x][y];
+                }
+                population += after;
+                births += (flipped + after - now) / 2;
+                deaths += (flipped - after + now) / 2;
+            }
+            if (HASH) {
+                for (int y = 0; y < WIDTH; y++) {
+                    if (arr[x][y] != res[x][y]) {
+                        hash_delta ^= zobrist_key(x, y, arr[x][y]) ^ zobrist_key(x, y, res[x][y]);
+                    }
                 }
             }
         }
+        if (COUNT) {
+            counters.population = population;
+            counters.births = births;
+            counters.deaths = deaths;
+            counters.hash_delta = hash_delta;
+        }
     }
 
     static sf::Color two_colors_judge(int32_t color_id) {
         return color_id ? sf::Color::Black : sf::Color::White;
     }
+
+    // Multi-state ids as GenerationsEngine uses them: 0 white, 1 black and
+    // dying states fading from dark to light blue.
+    static sf::Color generations_colors_judge(int32_t color_id) {
+        if (color_id <= 0) {
+            return sf::Color::White;
+        }
+        if (color_id == 1) {
+            return sf::Color::Black;
+        }
+        sf::Uint8 fade = static_cast<sf::Uint8>(std::min(200, 40 * (color_id - 1)));
+        return sf::Color(fade, fade, 255);
+    }
+
+    // Continuous states quantised to 0..255, as LeniaEngine reports them:
+    // white through blue and red to dark red, linear between the stops.
+    static sf::Color ramp_colors_judge(int32_t color_id) {
+        static const sf::Color stops[] = {
+            sf::Color::White, sf::Color(64, 96, 255), sf::Color(255, 64, 32), sf::Color(96, 0, 0)
+        };
+        const int32_t last = static_cast<int32_t>(sizeof(stops) / sizeof(stops[0])) - 1;
+        int32_t scaled = std::min(std::max(color_id, 0), 255) * last;
+        int32_t i = std::min(scaled / 255, last - 1);
+        int32_t t = scaled - i * 255;
+        auto mix = [&](sf::Uint8 a, sf::Uint8 b) {
+            return static_cast<sf::Uint8>((a * (255 - t) + b * t) / 255);
+        };
+        const sf::Color& from = stops[i];
+        const sf::Color& to = stops[i + 1];
+        return sf::Color(mix(from.r, to.r), mix(from.g, to.g), mix(from.b, to.b));
+    }
 };
 
     void output_info(const char* file_name = nullptr) {
+        LIFE_TRACE_SCOPE("output_info");
+        sync_field();
         std::ofstream out;
         if (file_name != nullptr) {
             out.open(file_name);
         }
-        for (auto row : field) {
+        for (const auto& row : fields.get_current()) {
             for (auto cell : row) {
                 if (file_name != nullptr) {
                     out << cell;
@@ -215,6 +677,8 @@ public:
     LifeGame() {
         rules = new Rules();
         judge_field = Rules::life_game_judge;
+        judge_field_counted = Rules::life_game_judge_counted;
+        judge_field_hashed = Rules::life_game_judge_hashed;
         judge_color = Rules::two_colors_judge;
     }
 
@@ -234,9 +698,9 @@ public:
     }
 
     bool prepare() {
+        sync_field();
         renew_window("Press 'S' to start, press '0' for white and '1' for black");
         bool was_released = true;
-        int32_t current_color = 1;
         while (true) {
             sf::Event event;
             while (window.pollEvent(event)) {
@@ -247,10 +711,7 @@ public:
             }
 
             if (event.type == sf::Event::MouseButtonPressed && was_released) {
-                int32_t& cell_mouse_points_to = get_cell_mouse_points_to();
-                if (cell_mouse_points_to != rules->_NOTCELL) {
-                    cell_mouse_points_to = current_color;
-                }
+                paint_cell_mouse_points_to();
                 was_released = false;
             }
             if (event.type == sf::Event::MouseButtonReleased) {
@@ -261,12 +722,13 @@ public:
                     return true;
                 }
                 if (event.text.unicode == '0') {
-                    current_color = 0;
+                    paint_color = 0;
                 }
                 if (event.text.unicode == '1') {
-                    current_color = 1;
+                    paint_color = 1;
                 }
             }
+            apply_edits();
             draw_field();
             window.display();
             window.clear(sf::Color::White);
@@ -277,18 +739,35 @@ public:
 
     void start() {
         if (!prepare()) return;
+        if (engine != nullptr) {
+            engine->load(fields.get_current());
+        }
+        if (cycle_detection) {
+            rehash();
+        }
         renew_window("Game of life");
         while (window.isOpen()) {
             sf::Event event;
             while (window.pollEvent(event)) {
                 if (event.type == sf::Event::Closed)
                     window.close();
+                if (event.type == sf::Event::MouseButtonPressed)
+                    paint_cell_mouse_points_to();
             }
 
+            apply_edits();
             draw_field();
-            window.display();
-            sf::sleep(get_sleep_time_milliseconds( rules->get_max_fps() ));
-            make_step();
+            {
+                LIFE_TRACE_SCOPE("window.display");
+                window.display();
+            }
+            {
+                LIFE_TRACE_SCOPE("sf::sleep");
+                sf::sleep(get_sleep_time_milliseconds( rules->get_max_fps() ));
+            }
+            if (!settled()) {
+                make_step();
+            }
             window.clear(sf::Color::White);
         }
     }
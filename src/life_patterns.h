@@ -0,0 +1,122 @@
+#ifndef LIFEGAME_LIFEPATTERNS_H
+#define LIFEGAME_LIFEPATTERNS_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Canonical Life patterns as lists of live cell coordinates, in the same
+// {x (row), y (column)} order the LifeGame initializer list uses.
+class LifePatterns {
+public:
+    using Cells = std::vector< std::pair<int32_t, int32_t> >;
+
+    // Rows of 'O' (alive) and '.' (dead), shifted to start at (x, y).
+    static Cells from_rows(const std::vector<std::string>& rows, int32_t x = 0, int32_t y = 0) {
+        Cells cells;
+        for (int32_t i = 0; i < static_cast<int32_t>(rows.size()); i++) {
+            for (int32_t j = 0; j < static_cast<int32_t>(rows[i].size()); j++) {
+                if (rows[i][j] == 'O') {
+                    cells.emplace_back(x + i, y + j);
+                }
+            }
+        }
+        return cells;
+    }
+
+    static Cells r_pentomino(int32_t x = 0, int32_t y = 0) {
+        return from_rows({
+            ".OO",
+            "OO.",
+            ".O.",
+        }, x, y);
+    }
+
+    static Cells acorn(int32_t x = 0, int32_t y = 0) {
+        return from_rows({
+            ".O.....",
+            "...O...",
+            "OO..OOO",
+        }, x, y);
+    }
+
+    static Cells block(int32_t x = 0, int32_t y = 0) {
+        return from_rows({
+            "OO",
+            "OO",
+        }, x, y);
+    }
+
+    static Cells blinker(int32_t x = 0, int32_t y = 0) {
+        return from_rows({
+            "OOO",
+        }, x, y);
+    }
+
+    static Cells glider(int32_t x = 0, int32_t y = 0) {
+        return from_rows({
+            ".O.",
+            "..O",
+            "OOO",
+        }, x, y);
+    }
+
+    static Cells gosper_glider_gun(int32_t x = 0, int32_t y = 0) {
+        return from_rows({
+            "........................O...........",
+            "......................O.O...........",
+            "............OO......OO............OO",
+            "...........O...O....OO............OO",
+            "OO........O.....O...OO..............",
+            "OO........O...O.OO....O.O...........",
+            "..........O.....O.......O...........",
+            "...........O...O....................",
+            "............OO......................",
+        }, x, y);
+    }
+
+    // A column of Gosper guns down the left edge whose streams run into each
+    // other's debris, so activity keeps growing across the board. Stands in
+    // for a breeder, which would not fit on the smaller boards of a sweep.
+    static Cells gun_breeder(int32_t height, int32_t width) {
+        Cells cells;
+        for (int32_t x = 1; x + 9 <= height && 37 <= width; x += 24) {
+            Cells gun = gosper_glider_gun(x, 1);
+            cells.insert(cells.end(), gun.begin(), gun.end());
+        }
+        return cells;
+    }
+
+    // Blocks and beehives packed edge to edge: every cell sits next to a still
+    // life, but nothing ever changes.
+    static Cells still_life_field(int32_t height, int32_t width) {
+        Cells cells;
+        for (int32_t x = 0; x + 4 <= height; x += 5) {
+            for (int32_t y = 0; y + 5 <= width; y += 6) {
+                Cells piece = ((x / 5 + y / 6) % 2 == 0)
+                    ? from_rows({ "OO", "OO" }, x + 1, y + 1)
+                    : from_rows({ ".OO.", "O..O", ".OO." }, x, y);
+                cells.insert(cells.end(), piece.begin(), piece.end());
+            }
+        }
+        return cells;
+    }
+
+    static Cells random_soup(int32_t height, int32_t width, double density, uint32_t seed) {
+        Cells cells;
+        std::mt19937 gen(seed);
+        std::bernoulli_distribution alive(density);
+        for (int32_t x = 0; x < height; x++) {
+            for (int32_t y = 0; y < width; y++) {
+                if (alive(gen)) {
+                    cells.emplace_back(x, y);
+                }
+            }
+        }
+        return cells;
+    }
+};
+
+#endif // LIFEGAME_LIFEPATTERNS_H
@@ -0,0 +1,109 @@
+#ifndef LIFEGAME_LIFESTATS_H
+#define LIFEGAME_LIFESTATS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// What one step did, filled in by the step kernel itself.
+struct GenerationCounters {
+    int64_t population {0};
+    int64_t births     {0};
+    int64_t deaths     {0};
+    uint64_t hash_delta {0}; // xor of the Zobrist keys of changed cells, if hashing
+    int64_t cache_hits   {0}; // tile cache lookups, for engines that have one
+    int64_t cache_misses {0};
+};
+
+// One generation as seen by the driver: `generation` is the index of the
+// board that was rendered, the step turned it into generation + 1.
+// Counters are -1 when the kernel in use does not report them. Allocations
+// are those the step made from the arena; arena bytes are in use after it.
+// Cache hits and misses stay 0 without a tile cache.
+struct GenerationRecord {
+    uint64_t generation  {0};
+    double   step_ms     {0};
+    double   render_ms   {0};
+    int64_t  population  {-1};
+    int64_t  births      {-1};
+    int64_t  deaths      {-1};
+    uint64_t allocations {0};
+    uint64_t arena_bytes {0};
+    int64_t  cache_hits  {0};
+    int64_t  cache_misses {0};
+};
+
+// Single-producer single-consumer ring of generation records. The simulation
+// thread pushes, any one other thread may poll or drain concurrently without
+// locks. When the ring is full new records are dropped and counted.
+template <size_t CAPACITY = 1024>
+class GenerationStatsRing {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+private:
+    std::array<GenerationRecord, CAPACITY> records {};
+    alignas(64) std::atomic<uint64_t> head {0}; // next slot to read
+    alignas(64) std::atomic<uint64_t> tail {0}; // next slot to write
+    std::atomic<uint64_t> dropped {0};
+public:
+    bool push(const GenerationRecord& record) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == CAPACITY) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        records[t & (CAPACITY - 1)] = record;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool poll(GenerationRecord& record) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        record = records[h & (CAPACITY - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t drain(std::vector<GenerationRecord>& out) {
+        size_t count = 0;
+        GenerationRecord record;
+        while (poll(record)) {
+            out.push_back(record);
+            count++;
+        }
+        return count;
+    }
+
+    uint64_t get_dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    static void write_csv(std::ostream& out, const std::vector<GenerationRecord>& list) {
+        out << "generation,step_ms,render_ms,population,births,deaths,allocations,arena_bytes,"
+               "cache_hits,cache_misses\n";
+        for (const GenerationRecord& r : list) {
+            out << r.generation << ',' << r.step_ms << ',' << r.render_ms << ','
+                << r.population << ',' << r.births << ',' << r.deaths << ','
+                << r.allocations << ',' << r.arena_bytes << ','
+                << r.cache_hits << ',' << r.cache_misses << '\n';
+        }
+    }
+
+    static void write_json(std::ostream& out, const std::vector<GenerationRecord>& list) {
+        out << "[\n";
+        for (size_t i = 0; i < list.size(); i++) {
+            const GenerationRecord& r = list[i];
+            out << "  {\"generation\": " << r.generation << ", \"step_ms\": " << r.step_ms
+                << ", \"render_ms\": " << r.render_ms << ", \"population\": " << r.population
+                << ", \"births\": " << r.births << ", \"deaths\": " << r.deaths
+                << ", \"allocations\": " << r.allocations << ", \"arena_bytes\": " << r.arena_bytes
+                << ", \"cache_hits\": " << r.cache_hits << ", \"cache_misses\": " << r.cache_misses << "}"
+                << (i + 1 < list.size() ? ",\n" : "\n");
+        }
+        out << "]\n";
+    }
+};
+
+#endif // LIFEGAME_LIFESTATS_H
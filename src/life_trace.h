@@ -0,0 +1,196 @@
+#ifndef LIFEGAME_LIFETRACE_H
+#define LIFEGAME_LIFETRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Timeline tracing in Chrome Trace Event format, viewable in chrome://tracing
+// or Perfetto. Scopes are marked with LIFE_TRACE_SCOPE("name"); names must be
+// string literals. LIFE_TRACE_COUNTER("name", value) adds a sample to a
+// counter track under the same rules. Tracing is compiled in unless
+// LIFEGAME_NO_TRACE is defined, and costs one relaxed atomic load per scope or
+// sample while it is not started.
+//
+//     LifeTrace::start("trace.json");
+//     ...
+//     LifeTrace::stop();   // writes the file
+
+class LifeTrace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // A scope, or with `counter` set a sample of `value` taken at `begin`.
+    struct Event {
+        const char* name;
+        Clock::time_point begin;
+        Clock::time_point end;
+        bool counter {false};
+        double value {0};
+    };
+
+    struct ThreadBuffer {
+        std::mutex lock;
+        std::vector<Event> events;
+        std::string thread_name;
+        uint32_t tid;
+    };
+
+private:
+    struct State {
+        std::atomic<bool> enabled {false};
+        std::mutex lock;
+        std::vector< std::shared_ptr<ThreadBuffer> > buffers;
+        std::string file_name;
+        Clock::time_point origin;
+        uint32_t next_tid {1};
+    };
+
+    static State& state() {
+        static State instance;
+        return instance;
+    }
+
+    static ThreadBuffer& thread_buffer() {
+        thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+            State& s = state();
+            std::lock_guard<std::mutex> guard(s.lock);
+            auto created = std::make_shared<ThreadBuffer>();
+            created->tid = s.next_tid++;
+            s.buffers.push_back(created);
+            return created;
+        }();
+        return *buffer;
+    }
+
+    static void write_string(std::ofstream& out, const std::string& text) {
+        out << '"';
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                out << '\\';
+            }
+            out << c;
+        }
+        out << '"';
+    }
+
+public:
+    static bool enabled() {
+        return state().enabled.load(std::memory_order_relaxed);
+    }
+
+    static void start(const char* file_name) {
+        State& s = state();
+        std::lock_guard<std::mutex> guard(s.lock);
+        for (auto& buffer : s.buffers) {
+            std::lock_guard<std::mutex> buffer_guard(buffer->lock);
+            buffer->events.clear();
+        }
+        s.file_name = file_name;
+        s.origin = Clock::now();
+        s.enabled.store(true, std::memory_order_relaxed);
+    }
+
+    // Stops recording and writes every thread's events to the file given to start().
+    static void stop() {
+        State& s = state();
+        std::lock_guard<std::mutex> guard(s.lock);
+        if (!s.enabled.exchange(false)) {
+            return;
+        }
+        std::ofstream out(s.file_name);
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        // Microseconds to the nanosecond; the default six significant digits
+        // would round timestamps past one second to 10 us and worse.
+        out << std::fixed << std::setprecision(3);
+        bool first = true;
+        for (auto& buffer : s.buffers) {
+            std::lock_guard<std::mutex> buffer_guard(buffer->lock);
+            if (!buffer->thread_name.empty()) {
+                out << (first ? "" : ",\n") << "{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": "
+                    << buffer->tid << ", \"args\": {\"name\": ";
+                write_string(out, buffer->thread_name);
+                out << "}}";
+                first = false;
+            }
+            for (const Event& event : buffer->events) {
+                double ts  = std::chrono::duration<double, std::micro>(event.begin - s.origin).count();
+                double dur = std::chrono::duration<double, std::micro>(event.end - event.begin).count();
+                out << (first ? "" : ",\n") << "{\"ph\": \"" << (event.counter ? 'C' : 'X') << "\", \"name\": ";
+                write_string(out, event.name);
+                out << ", \"pid\": 1, \"tid\": " << buffer->tid << ", \"ts\": " << ts;
+                if (event.counter) {
+                    out << ", \"args\": {\"value\": " << std::defaultfloat << std::setprecision(10) << event.value
+                        << std::fixed << std::setprecision(3) << "}}";
+                } else {
+                    out << ", \"dur\": " << dur << "}";
+                }
+                first = false;
+            }
+            buffer->events.clear();
+        }
+        out << "\n]}\n";
+    }
+
+    // Label for the calling thread's row in the viewer.
+    static void set_thread_name(const std::string& name) {
+        ThreadBuffer& buffer = thread_buffer();
+        std::lock_guard<std::mutex> guard(buffer.lock);
+        buffer.thread_name = name;
+    }
+
+    static void record(const char* name, Clock::time_point begin, Clock::time_point end) {
+        ThreadBuffer& buffer = thread_buffer();
+        std::lock_guard<std::mutex> guard(buffer.lock);
+        buffer.events.push_back(Event {name, begin, end});
+    }
+
+    static void counter(const char* name, double value) {
+        if (!enabled()) {
+            return;
+        }
+        Clock::time_point now = Clock::now();
+        ThreadBuffer& buffer = thread_buffer();
+        std::lock_guard<std::mutex> guard(buffer.lock);
+        buffer.events.push_back(Event {name, now, now, true, value});
+    }
+};
+
+class LifeTraceScope {
+private:
+    const char* name;
+    bool active;
+    LifeTrace::Clock::time_point begin;
+public:
+    explicit LifeTraceScope(const char* scope_name) : name(scope_name), active(LifeTrace::enabled()) {
+        if (active) {
+            begin = LifeTrace::Clock::now();
+        }
+    }
+    ~LifeTraceScope() {
+        if (active) {
+            LifeTrace::record(name, begin, LifeTrace::Clock::now());
+        }
+    }
+    LifeTraceScope(const LifeTraceScope&) = delete;
+    LifeTraceScope& operator=(const LifeTraceScope&) = delete;
+};
+
+#define LIFE_TRACE_CONCAT_INNER(a, b) a##b
+#define LIFE_TRACE_CONCAT(a, b) LIFE_TRACE_CONCAT_INNER(a, b)
+
+#ifdef LIFEGAME_NO_TRACE
+#define LIFE_TRACE_SCOPE(name) ((void)0)
+#define LIFE_TRACE_COUNTER(name, value) ((void)0)
+#else
+#define LIFE_TRACE_SCOPE(name) LifeTraceScope LIFE_TRACE_CONCAT(life_trace_scope_, __LINE__) (name)
+#define LIFE_TRACE_COUNTER(name, value) LifeTrace::counter(name, value)
+#endif
+
+#endif // LIFEGAME_LIFETRACE_H
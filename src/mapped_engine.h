@@ -0,0 +1,318 @@
+#ifndef LIFEGAME_MAPPEDENGINE_H
+#define LIFEGAME_MAPPEDENGINE_H
+
+#include <bit_grid.h>
+#include <life_trace.h>
+#include <mapped_file.h>
+#include <step_engine.h>
+#include <zobrist.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Bit-packed engine for boards larger than memory. The board lives in a
+// memory-mapped file as tiles of 64 rows by 64 words (32 KB), stored a band
+// of tiles at a time, left to right, so a generation that goes band by band
+// from the top reads and writes the file front to back.
+//
+// There is only one copy of the board. A band is read into a strip buffer
+// together with a row of halo above and below, stepped there, and its tiles
+// written back in place; the halo above must be the band's old last row, so
+// that row is kept from each band before it is overwritten. Tiles are
+// stepped only near activity, as in TiledEngine, and written back only if
+// they changed, so pages of settled regions are neither read nor dirtied.
+// The next band is prefetched while one is stepped, written tiles are queued
+// for write-back straight away, and the band before is released, which keeps
+// the resident set to a few bands whatever the board size.
+template <int HEIGHT, int WIDTH>
+class MappedEngine : public StepEngine<HEIGHT, WIDTH> {
+public:
+    static constexpr int32_t TILE_ROWS = 64;
+    static constexpr int32_t TILE_WORDS = 64;
+    static constexpr int32_t WORDS = (WIDTH + 63) / 64;
+    static constexpr int32_t TILES_X = (HEIGHT + TILE_ROWS - 1) / TILE_ROWS;
+    static constexpr int32_t TILES_Y = (WORDS + TILE_WORDS - 1) / TILE_WORDS;
+    static constexpr uint64_t TAIL_MASK = BitGrid<1, WIDTH>::TAIL_MASK;
+    static constexpr size_t TILE_BYTES = static_cast<size_t>(TILE_ROWS) * TILE_WORDS * sizeof(uint64_t);
+    static constexpr size_t BAND_BYTES = TILE_BYTES * TILES_Y;
+    static constexpr size_t FILE_BYTES = BAND_BYTES * TILES_X;
+
+    // What the last generation did to the file.
+    struct Stats {
+        int64_t bands_loaded {0};
+        int64_t tiles_stepped {0};
+        int64_t tiles_written {0};
+    };
+private:
+    // Strip rows -1 to TILE_ROWS of the band, words -1 to WORDS.
+    static constexpr int32_t STRIP_STRIDE = WORDS + 2;
+
+    MappedFile file;
+    std::vector<uint8_t> changed, next_changed;
+    std::vector<int64_t> tile_population;
+    std::vector<uint64_t> strip, next_strip;
+    // Old last row of the band above, for the tiles that were written.
+    std::vector<uint64_t> saved_row, next_saved_row;
+    std::vector<uint8_t> saved, next_saved;
+    std::vector<uint8_t> stepped, loaded;
+    Stats stats;
+
+    uint64_t* tile(int32_t tx, int32_t ty) {
+        return reinterpret_cast<uint64_t*>(file.data() + (static_cast<size_t>(tx) * TILES_Y + ty) * TILE_BYTES);
+    }
+    const uint64_t* tile(int32_t tx, int32_t ty) const {
+        return reinterpret_cast<const uint64_t*>(file.data() + (static_cast<size_t>(tx) * TILES_Y + ty) * TILE_BYTES);
+    }
+
+    // Word w of row x, straight from the file.
+    uint64_t file_word(int32_t x, int32_t w) const {
+        return tile(x / TILE_ROWS, w / TILE_WORDS)[(x % TILE_ROWS) * TILE_WORDS + w % TILE_WORDS];
+    }
+
+    uint64_t* strip_row(std::vector<uint64_t>& buffer, int32_t r) {
+        return buffer.data() + static_cast<size_t>(r + 1) * STRIP_STRIDE + 1;
+    }
+
+    bool neighbourhood_changed(int32_t tx, int32_t ty) const {
+        for (int32_t i = std::max(0, tx - 1); i <= std::min(TILES_X - 1, tx + 1); i++) {
+            for (int32_t j = std::max(0, ty - 1); j <= std::min(TILES_Y - 1, ty + 1); j++) {
+                if (changed[static_cast<size_t>(i) * TILES_Y + j]) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool band_active(int32_t tx) const {
+        if (tx < 0 || tx >= TILES_X) {
+            return false;
+        }
+        const uint8_t* flags = changed.data() + static_cast<size_t>(tx) * TILES_Y;
+        return std::any_of(flags, flags + TILES_Y, [](uint8_t flag) { return flag != 0; });
+    }
+
+    // Copies the words of tile column ty of band tx into the strip, with the
+    // halo rows: above from the saved row where that tile was rewritten.
+    void load_tile(int32_t tx, int32_t ty, int32_t rows) {
+        const int32_t x0 = tx * TILE_ROWS;
+        const int32_t w0 = ty * TILE_WORDS;
+        const int32_t count = std::min(TILE_WORDS, WORDS - w0);
+        const uint64_t* src = tile(tx, ty);
+        for (int32_t r = 0; r < rows; r++) {
+            std::memcpy(strip_row(strip, r) + w0, src + static_cast<size_t>(r) * TILE_WORDS, count * sizeof(uint64_t));
+        }
+        uint64_t* above = strip_row(strip, -1) + w0;
+        if (x0 == 0) {
+            std::fill(above, above + count, 0);
+        } else if (saved[ty]) {
+            std::copy(saved_row.begin() + w0, saved_row.begin() + w0 + count, above);
+        } else {
+            const uint64_t* last = tile(tx - 1, ty) + static_cast<size_t>(TILE_ROWS - 1) * TILE_WORDS;
+            std::copy(last, last + count, above);
+        }
+        uint64_t* below = strip_row(strip, rows) + w0;
+        if (x0 + rows >= HEIGHT) {
+            std::fill(below, below + count, 0);
+        } else {
+            std::copy(tile(tx + 1, ty), tile(tx + 1, ty) + count, below);
+        }
+    }
+
+    template <bool HASH>
+    void step_tile(int32_t tx, int32_t ty, int32_t rows, GenerationCounters& counters) {
+        const int32_t x0 = tx * TILE_ROWS;
+        const int32_t w0 = ty * TILE_WORDS;
+        const int32_t w1 = std::min(WORDS, w0 + TILE_WORDS);
+        int64_t population = 0;
+        for (int32_t r = 0; r < rows; r++) {
+            const uint64_t* center = strip_row(strip, r);
+            uint64_t* out = strip_row(next_strip, r);
+            for (int32_t w = w0; w < w1; w++) {
+                uint64_t cell = center[w];
+                uint64_t result = life_word_step(center + w - STRIP_STRIDE, center + w, center + w + STRIP_STRIDE);
+                if (w == WORDS - 1) {
+                    result &= TAIL_MASK;
+                }
+                out[w] = result;
+                population += __builtin_popcountll(result);
+                counters.births += __builtin_popcountll(result & ~cell);
+                counters.deaths += __builtin_popcountll(cell & ~result);
+                if (HASH) {
+                    for (uint64_t diff = result ^ cell; diff != 0; diff &= diff - 1) {
+                        counters.hash_delta ^= zobrist_key(x0 + r, w * 64 + __builtin_ctzll(diff));
+                    }
+                }
+            }
+        }
+        tile_population[static_cast<size_t>(tx) * TILES_Y + ty] = population;
+    }
+
+    // Writes a stepped tile back if it changed, keeping its old last row for
+    // the band below. Returns whether it changed.
+    bool store_tile(int32_t tx, int32_t ty, int32_t rows) {
+        const int32_t w0 = ty * TILE_WORDS;
+        const int32_t count = std::min(TILE_WORDS, WORDS - w0);
+        bool differs = false;
+        for (int32_t r = 0; r < rows && !differs; r++) {
+            differs = std::memcmp(strip_row(strip, r) + w0, strip_row(next_strip, r) + w0, count * sizeof(uint64_t)) != 0;
+        }
+        if (!differs) {
+            return false;
+        }
+        const uint64_t* last = strip_row(strip, rows - 1) + w0;
+        std::copy(last, last + count, next_saved_row.begin() + w0);
+        next_saved[ty] = 1;
+        uint64_t* dst = tile(tx, ty);
+        for (int32_t r = 0; r < rows; r++) {
+            std::memcpy(dst + static_cast<size_t>(r) * TILE_WORDS, strip_row(next_strip, r) + w0, count * sizeof(uint64_t));
+        }
+        file.flush((static_cast<size_t>(tx) * TILES_Y + ty) * TILE_BYTES, TILE_BYTES);
+        stats.tiles_written++;
+        return true;
+    }
+
+    template <bool HASH>
+    void step_bands(GenerationCounters& counters) {
+        std::fill(saved.begin(), saved.end(), 0);
+        for (int32_t tx = 0; tx < TILES_X; tx++) {
+            const int32_t rows = std::min(TILE_ROWS, HEIGHT - tx * TILE_ROWS);
+            const size_t first = static_cast<size_t>(tx) * TILES_Y;
+            bool any = false;
+            for (int32_t ty = 0; ty < TILES_Y; ty++) {
+                stepped[ty] = neighbourhood_changed(tx, ty);
+                any = any || stepped[ty];
+            }
+            if (band_active(tx) || band_active(tx + 1) || band_active(tx + 2)) {
+                file.prefetch((first + TILES_Y) * TILE_BYTES, BAND_BYTES);
+            }
+            std::fill(next_saved.begin(), next_saved.end(), 0);
+            if (any) {
+                stats.bands_loaded++;
+                for (int32_t ty = 0; ty < TILES_Y; ty++) {
+                    loaded[ty] = stepped[ty] || (ty > 0 && stepped[ty - 1]) || (ty + 1 < TILES_Y && stepped[ty + 1]);
+                    if (loaded[ty]) {
+                        load_tile(tx, ty, rows);
+                    }
+                }
+                for (int32_t ty = 0; ty < TILES_Y; ty++) {
+                    if (stepped[ty]) {
+                        step_tile<HASH>(tx, ty, rows, counters);
+                        stats.tiles_stepped++;
+                    }
+                }
+                // All tiles are stepped before any is written: a tile reads
+                // the old edge words of its neighbours.
+                for (int32_t ty = 0; ty < TILES_Y; ty++) {
+                    next_changed[first + ty] = stepped[ty] && store_tile(tx, ty, rows);
+                }
+            } else {
+                std::fill(next_changed.begin() + first, next_changed.begin() + first + TILES_Y, 0);
+            }
+            for (int32_t ty = 0; ty < TILES_Y; ty++) {
+                counters.population += tile_population[first + ty];
+            }
+            if (tx > 0) {
+                file.release((first - TILES_Y) * TILE_BYTES, BAND_BYTES);
+            }
+            std::swap(saved, next_saved);
+            std::swap(saved_row, next_saved_row);
+        }
+    }
+public:
+    // Maps the board onto the file at `path`, FILE_BYTES long, emptied
+    // unless `keep_contents`. Check is_open() before use.
+    explicit MappedEngine(const std::string& path, bool keep_contents = false)
+        : changed(static_cast<size_t>(TILES_X) * TILES_Y, 1),
+          next_changed(static_cast<size_t>(TILES_X) * TILES_Y, 0),
+          tile_population(static_cast<size_t>(TILES_X) * TILES_Y, 0),
+          strip(static_cast<size_t>(TILE_ROWS + 2) * STRIP_STRIDE, 0),
+          next_strip(static_cast<size_t>(TILE_ROWS + 2) * STRIP_STRIDE, 0),
+          saved_row(WORDS, 0), next_saved_row(WORDS, 0),
+          saved(TILES_Y, 0), next_saved(TILES_Y, 0), stepped(TILES_Y, 0), loaded(TILES_Y, 0) {
+        if (!file.open(path, FILE_BYTES, !keep_contents)) {
+            return;
+        }
+        if (keep_contents) {
+            for (int32_t tx = 0; tx < TILES_X; tx++) {
+                for (int32_t ty = 0; ty < TILES_Y; ty++) {
+                    const uint64_t* words = tile(tx, ty);
+                    int64_t population = 0;
+                    for (size_t i = 0; i < TILE_BYTES / sizeof(uint64_t); i++) {
+                        population += __builtin_popcountll(words[i]);
+                    }
+                    tile_population[static_cast<size_t>(tx) * TILES_Y + ty] = population;
+                }
+                file.release(static_cast<size_t>(tx) * BAND_BYTES, BAND_BYTES);
+            }
+        }
+    }
+
+    bool is_open() const { return file.is_open(); }
+
+    const char* name() const override { return "mapped"; }
+
+    // Zeroes only the tiles that hold live cells.
+    void clear() override {
+        for (int32_t tx = 0; tx < TILES_X; tx++) {
+            for (int32_t ty = 0; ty < TILES_Y; ty++) {
+                const size_t t = static_cast<size_t>(tx) * TILES_Y + ty;
+                if (tile_population[t] != 0) {
+                    std::memset(tile(tx, ty), 0, TILE_BYTES);
+                    tile_population[t] = 0;
+                    changed[t] = 1;
+                }
+            }
+        }
+    }
+
+    int32_t get_id(int32_t x, int32_t y) const override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            return (file_word(x, y >> 6) >> (y & 63)) & 1;
+        }
+        return -1;
+    }
+
+    void set_id(int32_t x, int32_t y, int32_t id) override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            const int32_t tx = x / TILE_ROWS, ty = (y >> 6) / TILE_WORDS;
+            uint64_t& word = tile(tx, ty)[(x % TILE_ROWS) * TILE_WORDS + (y >> 6) % TILE_WORDS];
+            const uint64_t bit = 1ULL << (y & 63);
+            const bool was = (word & bit) != 0, alive = id != 0;
+            if (was != alive) {
+                word ^= bit;
+                const size_t t = static_cast<size_t>(tx) * TILES_Y + ty;
+                tile_population[t] += alive ? 1 : -1;
+                changed[t] = 1;
+            }
+        }
+    }
+
+    int64_t get_population() const override {
+        int64_t population = 0;
+        for (int64_t count : tile_population) {
+            population += count;
+        }
+        return population;
+    }
+
+    void step(GenerationCounters& counters) override {
+        LIFE_TRACE_SCOPE("mapped_step");
+        counters = GenerationCounters {};
+        stats = Stats {};
+        if (this->hashing) {
+            step_bands<true>(counters);
+        } else {
+            step_bands<false>(counters);
+        }
+        std::swap(changed, next_changed);
+    }
+
+    const Stats& get_stats() const { return stats; }
+};
+
+#endif // LIFEGAME_MAPPEDENGINE_H
@@ -0,0 +1,186 @@
+#ifndef LIFEGAME_MAPPEDFILE_H
+#define LIFEGAME_MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// A file mapped read-write into memory, shared with the file so that pages
+// the program writes go back to it. The hints below take byte ranges of the
+// mapping and round them out to whole pages; where the system has no
+// equivalent they do nothing.
+class MappedFile {
+private:
+    uint8_t* base {nullptr};
+    size_t length {0};
+#ifdef _WIN32
+    HANDLE file {INVALID_HANDLE_VALUE};
+    HANDLE mapping {nullptr};
+#else
+    int fd {-1};
+#endif
+
+    static size_t page_size() {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwPageSize;
+#else
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+    // Page-aligned start and length covering [offset, offset + bytes).
+    bool pages(size_t offset, size_t bytes, uint8_t*& start, size_t& span) const {
+        if (base == nullptr || offset >= length || bytes == 0) {
+            return false;
+        }
+        const size_t page = page_size();
+        size_t begin = offset / page * page;
+        size_t end = offset + bytes < length ? offset + bytes : length;
+        start = base + begin;
+        span = end - begin;
+        return true;
+    }
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps `bytes` of the file at `path`, creating it if needed and resizing
+    // it to exactly `bytes`; new space reads as zeros and on most file systems
+    // takes no disk until written. With `truncate` old contents are dropped
+    // first. Returns false if the file cannot be opened, sized or mapped.
+    bool open(const std::string& path, size_t bytes, bool truncate) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                           truncate ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER size;
+        size.QuadPart = static_cast<LONGLONG>(bytes);
+        if (!SetFilePointerEx(file, size, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+            close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(bytes >> 32),
+                                     static_cast<DWORD>(bytes & 0xFFFFFFFFu), nullptr);
+        if (mapping == nullptr) {
+            close();
+            return false;
+        }
+        base = static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes));
+        if (base == nullptr) {
+            close();
+            return false;
+        }
+#else
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+        if (fd < 0) {
+            return false;
+        }
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            close();
+            return false;
+        }
+        void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close();
+            return false;
+        }
+        base = static_cast<uint8_t*>(mapped);
+#endif
+        length = bytes;
+        return true;
+    }
+
+    // Unmaps; dirty pages still reach the file.
+    void close() {
+#ifdef _WIN32
+        if (base != nullptr) {
+            UnmapViewOfFile(base);
+        }
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (base != nullptr) {
+            munmap(base, length);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = -1;
+#endif
+        base = nullptr;
+        length = 0;
+    }
+
+    bool is_open() const { return base != nullptr; }
+    uint8_t* data() { return base; }
+    const uint8_t* data() const { return base; }
+    size_t size() const { return length; }
+
+    // Asks for the range to be read in ahead of use.
+    void prefetch(size_t offset, size_t bytes) {
+        uint8_t* start;
+        size_t span;
+        if (pages(offset, bytes, start, span)) {
+#ifndef _WIN32
+            madvise(start, span, MADV_WILLNEED);
+#endif
+        }
+    }
+
+    // Starts writing the range's dirty pages back without waiting.
+    void flush(size_t offset, size_t bytes) {
+        uint8_t* start;
+        size_t span;
+        if (pages(offset, bytes, start, span)) {
+#ifdef _WIN32
+            FlushViewOfFile(start, span);
+#else
+            msync(start, span, MS_ASYNC);
+#endif
+        }
+    }
+
+    // Lets the range leave this process's resident set; the contents stay in
+    // the file and come back on the next access.
+    void release(size_t offset, size_t bytes) {
+        uint8_t* start;
+        size_t span;
+        if (pages(offset, bytes, start, span)) {
+#ifdef _WIN32
+            VirtualUnlock(start, span);
+#else
+            madvise(start, span, MADV_DONTNEED);
+#endif
+        }
+    }
+};
+
+#endif // LIFEGAME_MAPPEDFILE_H
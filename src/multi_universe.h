@@ -0,0 +1,194 @@
+#ifndef LIFEGAME_MULTIUNIVERSE_H
+#define LIFEGAME_MULTIUNIVERSE_H
+
+#include <bit_grid.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+// 64 independent two-state boards of one size stepped together: bit b of the
+// word for cell (x, y) is that cell in universe b, so one pass of the bitwise
+// adder over the board steps all 64 with no branches. Meant for rule and soup
+// sweeps on small boards, where a packed row is only a word or two and the
+// per-board kernels have little to chew on. Every row is framed by a zero word
+// on each side and the board by a zero row above and below, as in BitGrid.
+template <int HEIGHT, int WIDTH>
+class MultiUniverse {
+public:
+    static constexpr int32_t UNIVERSES = 64;
+    static constexpr int32_t STRIDE = WIDTH + 2;
+
+    using Field = std::array< std::array<int32_t, WIDTH>, HEIGHT >;
+private:
+    std::vector<uint64_t> cells, next_cells;
+    // Bit n set: a cell with n neighbours is born / survives.
+    uint32_t birth {1u << 3};
+    uint32_t survive {(1u << 2) | (1u << 3)};
+
+    uint64_t* row(std::vector<uint64_t>& words, int32_t x) {
+        return words.data() + static_cast<size_t>(x + 1) * STRIDE + 1;
+    }
+    const uint64_t* row(const std::vector<uint64_t>& words, int32_t x) const {
+        return words.data() + static_cast<size_t>(x + 1) * STRIDE + 1;
+    }
+
+    // Lanes whose count, given as bit planes, is one of those in `mask`.
+    static uint64_t count_in(uint32_t mask, uint64_t b0, uint64_t b1, uint64_t b2, uint64_t b3) {
+        uint64_t match = 0;
+        for (uint32_t n = 0; n <= 8; n++) {
+            if (mask & (1u << n)) {
+                match |= ((n & 1) ? b0 : ~b0) & ((n & 2) ? b1 : ~b1)
+                       & ((n & 4) ? b2 : ~b2) & ((n & 8) ? b3 : ~b3);
+            }
+        }
+        return match;
+    }
+
+    template <bool LIFE>
+    uint64_t step_rows() {
+        uint64_t changed = 0;
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            const uint64_t* above  = row(cells, x - 1);
+            const uint64_t* center = row(cells, x);
+            const uint64_t* below  = row(cells, x + 1);
+            uint64_t* out = row(next_cells, x);
+            for (int32_t y = 0; y < WIDTH; y++) {
+                uint64_t cell = center[y];
+                uint64_t result;
+                if (LIFE) {
+                    result = life_lanes_step(above[y - 1], above[y], above[y + 1], below[y - 1], below[y],
+                                             below[y + 1], center[y - 1], center[y + 1], cell);
+                } else {
+                    uint64_t b0, b1, b2, b3;
+                    life_lanes_count(above[y - 1], above[y], above[y + 1], below[y - 1], below[y],
+                                     below[y + 1], center[y - 1], center[y + 1], b0, b1, b2, b3);
+                    result = (cell & count_in(survive, b0, b1, b2, b3))
+                           | (~cell & count_in(birth, b0, b1, b2, b3));
+                }
+                out[y] = result;
+                changed |= result ^ cell;
+            }
+        }
+        return changed;
+    }
+public:
+    MultiUniverse()
+        : cells(static_cast<size_t>(HEIGHT + 2) * STRIDE, 0),
+          next_cells(static_cast<size_t>(HEIGHT + 2) * STRIDE, 0) {}
+
+    // Life-like rule as neighbour-count masks: bit n of `birth_mask` means a
+    // dead cell with n live neighbours is born, bit n of `survive_mask` that a
+    // live one survives. B3/S23 is stepped on a faster path.
+    void set_rule(uint32_t birth_mask, uint32_t survive_mask) {
+        birth = birth_mask & 0x1FF;
+        survive = survive_mask & 0x1FF;
+    }
+    uint32_t get_birth() const { return birth; }
+    uint32_t get_survive() const { return survive; }
+
+    void clear() {
+        std::fill(cells.begin(), cells.end(), 0);
+    }
+
+    int32_t get_id(int32_t universe, int32_t x, int32_t y) const {
+        if (0 <= universe && universe < UNIVERSES && 0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            return (row(cells, x)[y] >> universe) & 1;
+        }
+        return -1;
+    }
+
+    void set_id(int32_t universe, int32_t x, int32_t y, int32_t id) {
+        if (0 <= universe && universe < UNIVERSES && 0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            uint64_t& word = row(cells, x)[y];
+            uint64_t bit = 1ULL << universe;
+            word = id != 0 ? (word | bit) : (word & ~bit);
+        }
+    }
+
+    // Copies one universe from or to a LifeGame field; non-zero ids are alive.
+    void load(int32_t universe, const Field& field) {
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            for (int32_t y = 0; y < WIDTH; y++) {
+                set_id(universe, x, y, field[x][y]);
+            }
+        }
+    }
+    void store(int32_t universe, Field& field) const {
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            for (int32_t y = 0; y < WIDTH; y++) {
+                field[x][y] = get_id(universe, x, y);
+            }
+        }
+    }
+
+    // Fills every universe with a random soup, universe b seeded from
+    // `seed` + b as Ensemble seeds its board b, so the two can be compared.
+    void fill_random(double density, uint64_t seed) {
+        clear();
+        for (int32_t universe = 0; universe < UNIVERSES; universe++) {
+            std::mt19937_64 gen(seed + universe);
+            std::bernoulli_distribution alive(density);
+            for (int32_t x = 0; x < HEIGHT; x++) {
+                for (int32_t y = 0; y < WIDTH; y++) {
+                    if (alive(gen)) {
+                        set_id(universe, x, y, 1);
+                    }
+                }
+            }
+        }
+    }
+
+    // Steps all 64 universes one generation. Returns the universes in which
+    // any cell changed, one bit each.
+    uint64_t step() {
+        uint64_t changed = (birth == (1u << 3) && survive == ((1u << 2) | (1u << 3)))
+                         ? step_rows<true>() : step_rows<false>();
+        std::swap(cells, next_cells);
+        return changed;
+    }
+
+    // Live cells per universe. Words are summed into bit-sliced counters, one
+    // 64-lane plane per bit of the count, so adding a word is a short ripple
+    // carry instead of 64 separate increments.
+    std::array<int64_t, UNIVERSES> populations() const {
+        constexpr int32_t PLANES = 64 - __builtin_clzll(static_cast<uint64_t>(HEIGHT) * WIDTH);
+        uint64_t planes[PLANES] = {};
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            const uint64_t* r = row(cells, x);
+            for (int32_t y = 0; y < WIDTH; y++) {
+                uint64_t carry = r[y];
+                for (int32_t k = 0; k < PLANES && carry != 0; k++) {
+                    uint64_t next = planes[k] & carry;
+                    planes[k] ^= carry;
+                    carry = next;
+                }
+            }
+        }
+        std::array<int64_t, UNIVERSES> counts;
+        for (int32_t universe = 0; universe < UNIVERSES; universe++) {
+            int64_t count = 0;
+            for (int32_t k = 0; k < PLANES; k++) {
+                count |= static_cast<int64_t>((planes[k] >> universe) & 1) << k;
+            }
+            counts[universe] = count;
+        }
+        return counts;
+    }
+
+    // Universes with at least one live cell.
+    uint64_t alive() const {
+        uint64_t any = 0;
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            const uint64_t* r = row(cells, x);
+            for (int32_t y = 0; y < WIDTH; y++) {
+                any |= r[y];
+            }
+        }
+        return any;
+    }
+};
+
+#endif // LIFEGAME_MULTIUNIVERSE_H
@@ -0,0 +1,125 @@
+#ifndef LIFEGAME_NUMA_H
+#define LIFEGAME_NUMA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+// Thread placement and memory locality on multi-socket machines. Memory goes
+// to the node of the thread that first writes it, so data a thread works on
+// should be first touched by that thread, pinned where it will stay.
+
+// Restricts the calling thread to `cpus`. Returns false if the system
+// refused or cannot pin; an empty set leaves the thread alone.
+inline bool pin_current_thread(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return true;
+    }
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (0 <= cpu && cpu < static_cast<int>(8 * sizeof(DWORD_PTR))) {
+            mask |= static_cast<DWORD_PTR>(1) << cpu;
+        }
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (0 <= cpu && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+// Pages of a memory range by the node they are on. Pages not yet touched,
+// or whose node the system will not say, count as unplaced.
+struct NumaPlacement {
+    std::vector<int64_t> node_pages;
+    int64_t unplaced {0};
+
+    void add(const NumaPlacement& other) {
+        if (node_pages.size() < other.node_pages.size()) {
+            node_pages.resize(other.node_pages.size(), 0);
+        }
+        for (size_t node = 0; node < other.node_pages.size(); node++) {
+            node_pages[node] += other.node_pages[node];
+        }
+        unplaced += other.unplaced;
+    }
+};
+
+inline size_t system_page_size() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// Where the pages of [begin, begin + bytes) are. Linux asks move_pages()
+// without moving anything; elsewhere every page is unplaced.
+inline NumaPlacement numa_placement(const void* begin, size_t bytes) {
+    NumaPlacement placement;
+    if (bytes == 0) {
+        return placement;
+    }
+    const size_t page = system_page_size();
+    const uintptr_t first = reinterpret_cast<uintptr_t>(begin) / page * page;
+    const uintptr_t end = reinterpret_cast<uintptr_t>(begin) + bytes;
+    const size_t count = (end - first + page - 1) / page;
+#ifdef __linux__
+    const size_t BATCH = 1024;
+    std::vector<void*> pages(BATCH);
+    std::vector<int> status(BATCH);
+    for (size_t done = 0; done < count; done += BATCH) {
+        const size_t n = count - done < BATCH ? count - done : BATCH;
+        for (size_t i = 0; i < n; i++) {
+            pages[i] = reinterpret_cast<void*>(first + (done + i) * page);
+        }
+        if (syscall(SYS_move_pages, 0, n, pages.data(), nullptr, status.data(), 0) != 0) {
+            placement.unplaced += static_cast<int64_t>(n);
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (status[i] < 0) {
+                placement.unplaced++;
+                continue;
+            }
+            if (placement.node_pages.size() <= static_cast<size_t>(status[i])) {
+                placement.node_pages.resize(status[i] + 1, 0);
+            }
+            placement.node_pages[status[i]]++;
+        }
+    }
+#else
+    placement.unplaced = static_cast<int64_t>(count);
+#endif
+    return placement;
+}
+
+#endif // LIFEGAME_NUMA_H
@@ -0,0 +1,297 @@
+#ifndef LIFEGAME_PATTERNMATCHER_H
+#define LIFEGAME_PATTERNMATCHER_H
+
+#include <bit_grid.h>
+#include <life_patterns.h>
+#include <life_trace.h>
+#include <thread_pool.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Finds known objects on a bit-packed board. Each pattern is compiled once
+// into every phase and orientation it has, and each of those into a list of
+// probes: its live cells, then the dead cells around it (every cell within
+// one of a live cell that is not live itself). A probe reads the board row
+// shifted so that bit j lines up with candidate column 64 * w + j, so one
+// pass over the probes tests 64 placements at once, and most placements are
+// ruled out by the first probe or two. Rows are scanned in bands, one band
+// per thread-pool task.
+//
+// A variant must be at most MAX_WIDTH columns wide so its envelope fits in a
+// word; a pattern too wide in every orientation is rejected.
+template <int HEIGHT, int WIDTH>
+class PatternMatcher {
+public:
+    using Grid = BitGrid<HEIGHT, WIDTH>;
+    using Cells = LifePatterns::Cells;
+
+    static constexpr int32_t MAX_WIDTH = 62;
+    static constexpr int32_t MAX_PERIOD = 64;
+    static constexpr int32_t TILE_ROWS = 64;
+    static constexpr int32_t BANDS = (HEIGHT + TILE_ROWS - 1) / TILE_ROWS;
+
+    struct Hit {
+        int32_t pattern;
+        int32_t phase;    // generations on from the pattern as added
+        int32_t symmetry; // bit 2: transposed, bit 1: rows flipped, bit 0: columns flipped
+        int32_t x, y;     // top-left of the variant's bounding box
+    };
+private:
+    // Reads (r[offset] >> shift) | (r[offset + 1] << (64 - shift)) relative
+    // to word w of the candidate's first row, flipped for dead cells.
+    struct Probe {
+        ptrdiff_t offset;
+        int32_t shift;
+        uint64_t flip;
+    };
+
+    struct Variant {
+        int32_t pattern, phase, symmetry;
+        int32_t height, width;
+        Cells cells; // normalised, sorted
+        std::vector<Probe> probes;
+    };
+
+    std::vector<std::string> names;
+    std::vector<Variant> variants;
+    std::vector<Hit> hits;
+    std::vector<uint64_t> counts;
+    std::vector< std::vector<Hit> > band_hits;
+    ThreadPool pool;
+
+    // Shifts the cells to start at (0, 0) and sorts them.
+    static void normalise(Cells& cells) {
+        int32_t min_x = INT32_MAX, min_y = INT32_MAX;
+        for (const auto& cell : cells) {
+            min_x = std::min(min_x, cell.first);
+            min_y = std::min(min_y, cell.second);
+        }
+        for (auto& cell : cells) {
+            cell.first -= min_x;
+            cell.second -= min_y;
+        }
+        std::sort(cells.begin(), cells.end());
+    }
+
+    // One Life generation of a small pattern on an otherwise empty board.
+    static Cells step_cells(const Cells& cells) {
+        int32_t height = 0, width = 0;
+        for (const auto& cell : cells) {
+            height = std::max(height, cell.first + 1);
+            width = std::max(width, cell.second + 1);
+        }
+        // One cell of margin each side for births, one more for neighbours.
+        const int32_t stride = width + 4;
+        std::vector<uint8_t> alive(static_cast<size_t>(height + 4) * stride, 0);
+        for (const auto& cell : cells) {
+            alive[static_cast<size_t>(cell.first + 2) * stride + cell.second + 2] = 1;
+        }
+        Cells next;
+        for (int32_t x = 1; x < height + 3; x++) {
+            for (int32_t y = 1; y < width + 3; y++) {
+                int32_t count = 0;
+                for (int32_t dx = -1; dx <= 1; dx++) {
+                    for (int32_t dy = -1; dy <= 1; dy++) {
+                        count += alive[static_cast<size_t>(x + dx) * stride + y + dy];
+                    }
+                }
+                uint8_t self = alive[static_cast<size_t>(x) * stride + y];
+                count -= self;
+                if (count == 3 || (self && count == 2)) {
+                    next.emplace_back(x - 2, y - 2);
+                }
+            }
+        }
+        return next;
+    }
+
+    static Cells transform(const Cells& cells, int32_t symmetry) {
+        Cells moved;
+        for (const auto& cell : cells) {
+            int32_t x = cell.first, y = cell.second;
+            if (symmetry & 4) {
+                std::swap(x, y);
+            }
+            if (symmetry & 2) {
+                x = -x;
+            }
+            if (symmetry & 1) {
+                y = -y;
+            }
+            moved.emplace_back(x, y);
+        }
+        normalise(moved);
+        return moved;
+    }
+
+    static std::vector<Probe> compile(const Cells& cells, int32_t height, int32_t width) {
+        const int32_t stride = width + 2;
+        std::vector<uint8_t> alive(static_cast<size_t>(height + 2) * stride, 0);
+        std::vector<Probe> probes;
+        for (const auto& cell : cells) {
+            alive[static_cast<size_t>(cell.first + 1) * stride + cell.second + 1] = 1;
+            probes.push_back(probe(cell.first, cell.second, true));
+        }
+        for (int32_t x = -1; x <= height; x++) {
+            for (int32_t y = -1; y <= width; y++) {
+                if (alive[static_cast<size_t>(x + 1) * stride + y + 1]) {
+                    continue;
+                }
+                bool near = false;
+                for (int32_t dx = -1; dx <= 1 && !near; dx++) {
+                    for (int32_t dy = -1; dy <= 1 && !near; dy++) {
+                        int32_t nx = x + dx, ny = y + dy;
+                        near = 0 <= nx && nx < height && 0 <= ny && ny < width
+                            && alive[static_cast<size_t>(nx + 1) * stride + ny + 1];
+                    }
+                }
+                if (near) {
+                    probes.push_back(probe(x, y, false));
+                }
+            }
+        }
+        return probes;
+    }
+
+    // Probe for cell (dx, dy) from the top-left of the bounding box, lined
+    // up so bit j is that cell for the candidate at column 64 * w + j.
+    static Probe probe(int32_t dx, int32_t dy, bool alive) {
+        int32_t word = dy < 0 ? -1 : 0;
+        return Probe {static_cast<ptrdiff_t>(dx) * Grid::STRIDE + word, dy - 64 * word, alive ? 0 : ~0ULL};
+    }
+
+    // The first probe of every variant is a live cell in row 0 at column
+    // 0 to MAX_WIDTH - 1, so a word with nothing there is skipped for all of
+    // them at once; on settled boards that is most of the board.
+    void scan_band(const Grid& grid, int32_t band, std::vector<Hit>& out) const {
+        const int32_t x_begin = band * TILE_ROWS;
+        const int32_t x_end = std::min(HEIGHT, x_begin + TILE_ROWS);
+        for (int32_t x = x_begin; x < x_end; x++) {
+            const uint64_t* row = grid.row(x);
+            for (int32_t w = 0; w < Grid::WORDS; w++) {
+                if ((row[w] | row[w + 1]) == 0) {
+                    continue;
+                }
+                const uint64_t* base = row + w;
+                for (const Variant& variant : variants) {
+                    if (x + variant.height > HEIGHT) {
+                        continue;
+                    }
+                    uint64_t match = ~0ULL;
+                    for (const Probe& probe : variant.probes) {
+                        const uint64_t* r = base + probe.offset;
+                        // Two shifts, so a shift of 0 needs no special case.
+                        match &= ((r[0] >> probe.shift) | ((r[1] << 1) << (63 - probe.shift))) ^ probe.flip;
+                        if (match == 0) {
+                            break;
+                        }
+                    }
+                    for (; match != 0; match &= match - 1) {
+                        out.push_back(Hit {variant.pattern, variant.phase, variant.symmetry,
+                                           x, w * 64 + __builtin_ctzll(match)});
+                    }
+                }
+            }
+        }
+    }
+
+public:
+    // `threads` counts the calling thread; 0 means one per hardware thread.
+    explicit PatternMatcher(size_t threads = 0) : band_hits(BANDS), pool(threads) {}
+
+    // Adds a pattern under `name`. With `all_phases` it is stepped on its own
+    // until it comes back to its starting shape, anywhere, within MAX_PERIOD
+    // generations and every phase on the way is matched too; patterns that
+    // do not come back are matched as given. Returns the pattern's index, or
+    // -1 if it is empty or too wide.
+    int32_t add_pattern(const std::string& name, const Cells& cells, bool all_phases = true) {
+        Cells start = cells;
+        normalise(start);
+        if (start.empty()) {
+            return -1;
+        }
+        std::vector<Cells> phases {start};
+        if (all_phases) {
+            Cells phase = start;
+            for (int32_t generation = 1; generation <= MAX_PERIOD; generation++) {
+                phase = step_cells(phase);
+                normalise(phase);
+                if (phase == start) {
+                    break;
+                }
+                if (phase.empty() || generation == MAX_PERIOD) {
+                    phases.resize(1);
+                    break;
+                }
+                phases.push_back(phase);
+            }
+        }
+
+        const int32_t pattern = static_cast<int32_t>(names.size());
+        const size_t first = variants.size();
+        for (int32_t phase = 0; phase < static_cast<int32_t>(phases.size()); phase++) {
+            for (int32_t symmetry = 0; symmetry < 8; symmetry++) {
+                Cells moved = transform(phases[phase], symmetry);
+                bool seen = false;
+                for (size_t i = first; i < variants.size() && !seen; i++) {
+                    seen = variants[i].cells == moved;
+                }
+                int32_t height = 0, width = 0;
+                for (const auto& cell : moved) {
+                    height = std::max(height, cell.first + 1);
+                    width = std::max(width, cell.second + 1);
+                }
+                if (seen || width > MAX_WIDTH) {
+                    continue;
+                }
+                std::vector<Probe> probes = compile(moved, height, width);
+                variants.push_back(Variant {pattern, phase, symmetry, height, width, std::move(moved), std::move(probes)});
+            }
+        }
+        if (variants.size() == first) {
+            return -1;
+        }
+        names.push_back(name);
+        counts.push_back(0);
+        return pattern;
+    }
+
+    // Gliders, blocks and blinkers.
+    void add_common_patterns() {
+        add_pattern("glider", LifePatterns::glider());
+        add_pattern("block", LifePatterns::block());
+        add_pattern("blinker", LifePatterns::blinker());
+    }
+
+    size_t patterns() const { return names.size(); }
+    size_t variant_count() const { return variants.size(); }
+    const std::string& get_name(int32_t pattern) const { return names[pattern]; }
+
+    // Finds every pattern on `grid`. Hits come in row order.
+    const std::vector<Hit>& scan(const Grid& grid) {
+        LIFE_TRACE_SCOPE("pattern_scan");
+        pool.parallel_for(BANDS, [&](size_t band) {
+            band_hits[band].clear();
+            scan_band(grid, static_cast<int32_t>(band), band_hits[band]);
+        });
+        hits.clear();
+        std::fill(counts.begin(), counts.end(), 0);
+        for (const std::vector<Hit>& band : band_hits) {
+            for (const Hit& hit : band) {
+                counts[hit.pattern]++;
+            }
+            hits.insert(hits.end(), band.begin(), band.end());
+        }
+        return hits;
+    }
+
+    const std::vector<Hit>& get_hits() const { return hits; }
+    // Hits per pattern in the last scan.
+    const std::vector<uint64_t>& get_counts() const { return counts; }
+};
+
+#endif // LIFEGAME_PATTERNMATCHER_H
@@ -0,0 +1,283 @@
+#ifndef LIFEGAME_SHAREDBOARD_H
+#define LIFEGAME_SHAREDBOARD_H
+
+#include <bit_grid.h>
+#include <life_stats.h>
+#include <life_trace.h>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// A bit-packed board in a POSIX shared-memory segment, stepped by worker
+// processes that each own a band of rows. The segment holds a header and two
+// boards laid out like BitGrid; generation g is in board g % 2 and the next
+// one is written into the other, so bands read their neighbours' rows
+// straight from the segment and nothing is exchanged. Workers meet at a
+// futex barrier after every generation; the last one in publishes the new
+// generation number.
+//
+// One process creates the segment, loads it and asks for generations;
+// worker processes attach writable and serve until it stops them; viewers
+// attach read-only and read the current board in place. Futexes make this
+// Linux only.
+template <int HEIGHT, int WIDTH>
+class SharedBoard {
+public:
+    static constexpr int32_t WORDS = BitGrid<HEIGHT, WIDTH>::WORDS;
+    static constexpr int32_t STRIDE = BitGrid<HEIGHT, WIDTH>::STRIDE;
+    static constexpr uint64_t TAIL_MASK = BitGrid<HEIGHT, WIDTH>::TAIL_MASK;
+    static constexpr int32_t MAX_WORKERS = 256;
+    static constexpr size_t BOARD_WORDS = static_cast<size_t>(HEIGHT + 2) * STRIDE;
+private:
+    static constexpr uint64_t MAGIC = 0x4C49464553484D31ULL; // "LIFESHM1"
+
+    // What one worker did since the last request, on its own cache line.
+    struct alignas(64) Slot {
+        GenerationCounters counters;
+    };
+
+    struct alignas(64) Header {
+        uint64_t magic;
+        int32_t height, width, workers;
+        uint32_t hashing;
+        // Futex words: generations asked for, generations done, barrier phase.
+        alignas(64) std::atomic<uint32_t> target;
+        alignas(64) std::atomic<uint32_t> generation;
+        alignas(64) std::atomic<uint32_t> phase;
+        std::atomic<uint32_t> arrived;
+        std::atomic<uint32_t> quit;
+        Slot slots[MAX_WORKERS];
+    };
+
+    static constexpr size_t BOARDS_OFFSET = (sizeof(Header) + 63) / 64 * 64;
+    static constexpr size_t SEGMENT_BYTES = BOARDS_OFFSET + 2 * BOARD_WORDS * sizeof(uint64_t);
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "futex words must be plain 32-bit words");
+
+    uint8_t* base {nullptr};
+    bool writable {false};
+
+    Header* header() { return reinterpret_cast<Header*>(base); }
+    const Header* header() const { return reinterpret_cast<const Header*>(base); }
+
+    uint64_t* board(uint32_t generation) {
+        return reinterpret_cast<uint64_t*>(base + BOARDS_OFFSET) + (generation & 1) * BOARD_WORDS + STRIDE + 1;
+    }
+    const uint64_t* board(uint32_t generation) const {
+        return reinterpret_cast<const uint64_t*>(base + BOARDS_OFFSET) + (generation & 1) * BOARD_WORDS + STRIDE + 1;
+    }
+
+    // Shared, not FUTEX_PRIVATE: the waiters are in different processes.
+    static void futex_wait(const std::atomic<uint32_t>& word, uint32_t expected) {
+        syscall(SYS_futex, reinterpret_cast<const uint32_t*>(&word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+    }
+    static void futex_wake(std::atomic<uint32_t>& word) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+
+    // Sense-reversing barrier over all workers; the last to arrive finishes
+    // the generation before it lets the others go.
+    void barrier(uint32_t finished) {
+        Header* h = header();
+        uint32_t phase = h->phase.load(std::memory_order_acquire);
+        if (h->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == static_cast<uint32_t>(h->workers)) {
+            h->arrived.store(0, std::memory_order_relaxed);
+            h->generation.store(finished, std::memory_order_release);
+            futex_wake(h->generation);
+            h->phase.store(phase + 1, std::memory_order_release);
+            futex_wake(h->phase);
+        } else {
+            while (h->phase.load(std::memory_order_acquire) == phase) {
+                futex_wait(h->phase, phase);
+            }
+        }
+    }
+
+    bool map(const std::string& name, int flags, bool write) {
+        close();
+        int fd = shm_open(name.c_str(), flags, 0600);
+        if (fd < 0) {
+            return false;
+        }
+        if ((flags & O_CREAT) && ftruncate(fd, static_cast<off_t>(SEGMENT_BYTES)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, SEGMENT_BYTES, write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        base = static_cast<uint8_t*>(mapped);
+        writable = write;
+        return true;
+    }
+public:
+    SharedBoard() = default;
+    ~SharedBoard() { close(); }
+
+    SharedBoard(const SharedBoard&) = delete;
+    SharedBoard& operator=(const SharedBoard&) = delete;
+
+    // Creates segment `name` ("/something") for `workers` workers, with an
+    // empty board at generation 0. Fails if it exists already.
+    bool create(const std::string& name, int32_t workers, bool hashing = false) {
+        if (workers < 1 || workers > MAX_WORKERS || workers > HEIGHT ||
+            !map(name, O_CREAT | O_EXCL | O_RDWR, true)) {
+            return false;
+        }
+        Header* h = new (base) Header {};
+        h->height = HEIGHT;
+        h->width = WIDTH;
+        h->workers = workers;
+        h->hashing = hashing;
+        std::atomic_thread_fence(std::memory_order_release);
+        h->magic = MAGIC;
+        return true;
+    }
+
+    // Attaches to an existing segment made for the same board size, writable
+    // for workers or read-only for viewers.
+    bool attach(const std::string& name, bool write) {
+        if (!map(name, write ? O_RDWR : O_RDONLY, write)) {
+            return false;
+        }
+        const Header* h = header();
+        if (h->magic != MAGIC || h->height != HEIGHT || h->width != WIDTH) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (base != nullptr) {
+            munmap(base, SEGMENT_BYTES);
+        }
+        base = nullptr;
+    }
+
+    // Removes the name; mappings stay valid until closed.
+    static void remove(const std::string& name) { shm_unlink(name.c_str()); }
+
+    bool is_open() const { return base != nullptr; }
+    bool is_writable() const { return writable; }
+    int32_t worker_count() const { return header()->workers; }
+
+    // Generations done so far; the current board is generation % 2.
+    uint32_t get_generation() const { return header()->generation.load(std::memory_order_acquire); }
+
+    // Word 0 of row x (-1 to HEIGHT) of generation `generation`'s board. The
+    // workers may overwrite it as soon as generation + 1 is done, so a viewer
+    // that reads while they run checks get_generation() is still `generation`
+    // afterwards to know the read was clean.
+    const uint64_t* row(uint32_t generation, int32_t x) const {
+        return board(generation) + static_cast<ptrdiff_t>(x) * STRIDE;
+    }
+
+    bool get(int32_t x, int32_t y) const {
+        return (row(get_generation(), x)[y >> 6] >> (y & 63)) & 1;
+    }
+
+    int64_t get_population() const {
+        const uint64_t* cells = board(get_generation());
+        int64_t population = 0;
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            for (int32_t w = 0; w < WORDS; w++) {
+                population += __builtin_popcountll(cells[static_cast<ptrdiff_t>(x) * STRIDE + w]);
+            }
+        }
+        return population;
+    }
+
+    // Creator only, between step() calls.
+    void set(int32_t x, int32_t y, bool alive) {
+        uint64_t& word = board(get_generation())[static_cast<ptrdiff_t>(x) * STRIDE + (y >> 6)];
+        uint64_t bit = 1ULL << (y & 63);
+        word = alive ? word | bit : word & ~bit;
+    }
+
+    void load(const BitGrid<HEIGHT, WIDTH>& grid) {
+        std::memcpy(board(get_generation()) - STRIDE - 1, grid.row(-1) - 1, BOARD_WORDS * sizeof(uint64_t));
+    }
+
+    // Creator only: has the workers run `generations` more generations and
+    // waits for them. Counters are combined as in StepEngine::make_step.
+    void step(int32_t generations, GenerationCounters& counters) {
+        LIFE_TRACE_SCOPE("shared_step");
+        Header* h = header();
+        for (int32_t i = 0; i < h->workers; i++) {
+            h->slots[i].counters = GenerationCounters {};
+        }
+        const uint32_t target = h->target.load(std::memory_order_relaxed) + static_cast<uint32_t>(generations);
+        h->target.store(target, std::memory_order_release);
+        futex_wake(h->target);
+        for (uint32_t done; (done = h->generation.load(std::memory_order_acquire)) != target;) {
+            futex_wait(h->generation, done);
+        }
+        counters = GenerationCounters {};
+        for (int32_t i = 0; i < h->workers; i++) {
+            const GenerationCounters& slot = h->slots[i].counters;
+            counters.population += slot.population;
+            counters.births += slot.births;
+            counters.deaths += slot.deaths;
+            counters.hash_delta ^= slot.hash_delta;
+        }
+    }
+
+    // Creator only: lets run_worker() return in every worker.
+    void stop() {
+        Header* h = header();
+        h->quit.store(1, std::memory_order_release);
+        h->target.fetch_add(1, std::memory_order_release);
+        futex_wake(h->target);
+    }
+
+    // Worker `index` of worker_count(): steps its band whenever generations
+    // are asked for, until stop().
+    void run_worker(int32_t index) {
+        Header* h = header();
+        int32_t x0 = static_cast<int32_t>(static_cast<int64_t>(HEIGHT) * index / h->workers);
+        int32_t x1 = static_cast<int32_t>(static_cast<int64_t>(HEIGHT) * (index + 1) / h->workers);
+        Slot& slot = h->slots[index];
+        uint32_t generation = h->generation.load(std::memory_order_acquire);
+        for (;;) {
+            uint32_t target;
+            while ((target = h->target.load(std::memory_order_acquire)) == generation &&
+                   !h->quit.load(std::memory_order_acquire)) {
+                futex_wait(h->target, target);
+            }
+            if (h->quit.load(std::memory_order_acquire)) {
+                return;
+            }
+            GenerationCounters counters;
+            if (h->hashing) {
+                life_step_rows<true>(board(generation), board(generation + 1), STRIDE, WORDS, TAIL_MASK, x0, x1, 0,
+                                     WORDS, counters);
+            } else {
+                life_step_rows<false>(board(generation), board(generation + 1), STRIDE, WORDS, TAIL_MASK, x0, x1, 0,
+                                      WORDS, counters);
+            }
+            slot.counters.population = counters.population;
+            slot.counters.births += counters.births;
+            slot.counters.deaths += counters.deaths;
+            slot.counters.hash_delta ^= counters.hash_delta;
+            barrier(++generation);
+        }
+    }
+};
+
+#endif // __linux__
+
+#endif // LIFEGAME_SHAREDBOARD_H
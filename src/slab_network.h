@@ -0,0 +1,479 @@
+#ifndef LIFEGAME_SLABNETWORK_H
+#define LIFEGAME_SLABNETWORK_H
+
+#include <bit_grid.h>
+#include <life_stats.h>
+#include <life_trace.h>
+#include <zobrist.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <SFML/Network.hpp>
+
+// One board split across processes by rows: each worker owns a slab of whole
+// rows, and every generation swaps its first and last rows with the workers
+// above and below over TCP. A coordinator hands out the slabs, drives the
+// generations and gathers the board back.
+//
+// Workers connect to the coordinator and report the port of their own
+// listener; once all are in, the coordinator tells each its rows and where
+// the worker above listens, worker i connects up to worker i - 1 and accepts
+// worker i + 1. Rows travel as packets of the row's words; messages on one
+// connection arrive in order, so halos need no generation tag.
+namespace slab_message {
+    enum : sf::Uint8 {
+        HELLO,      // worker: listener port
+        ASSIGN,     // coordinator: index, count, first row, end row, hashing, upper address and port
+        READY,      // worker: neighbours connected or not
+        LOAD,       // coordinator: row, words
+        STEP,       // coordinator: generations
+        COUNTERS,   // worker: population, births, deaths, hash delta
+        SNAPSHOT,   // coordinator: send the slab
+        ROW,        // worker: row, words
+        QUIT,
+    };
+}
+
+// Slab boundaries: rows [x0, x1) of the board for worker index of count.
+inline void slab_rows(int32_t height, int32_t index, int32_t count, int32_t& x0, int32_t& x1) {
+    x0 = static_cast<int32_t>(static_cast<int64_t>(height) * index / count);
+    x1 = static_cast<int32_t>(static_cast<int64_t>(height) * (index + 1) / count);
+}
+
+template <int HEIGHT, int WIDTH>
+class SlabWorker {
+public:
+    static constexpr int32_t WORDS = BitGrid<HEIGHT, WIDTH>::WORDS;
+    static constexpr int32_t STRIDE = BitGrid<HEIGHT, WIDTH>::STRIDE;
+    static constexpr uint64_t TAIL_MASK = BitGrid<HEIGHT, WIDTH>::TAIL_MASK;
+    // Interior rows stepped between polls of the neighbour sockets.
+    static constexpr int32_t POLL_ROWS = 16;
+private:
+    sf::TcpSocket coordinator;
+    sf::TcpListener listener;
+    // Neighbour links, null at the top and bottom of the board.
+    std::unique_ptr<sf::TcpSocket> upper, lower;
+    int32_t x0 {0}, rows {0};
+    bool hashing {false};
+    // Slab rows -1 to rows, laid out like BitGrid; rows -1 and `rows` are
+    // the neighbours' halos.
+    std::vector<uint64_t> cells, next_cells;
+
+    uint64_t* row(std::vector<uint64_t>& buffer, int32_t r) {
+        return buffer.data() + static_cast<size_t>(r + 1) * STRIDE + 1;
+    }
+
+    static void write_row(sf::Packet& packet, const uint64_t* words) {
+        for (int32_t w = 0; w < WORDS; w++) {
+            packet << static_cast<sf::Uint64>(words[w]);
+        }
+    }
+
+    static bool read_row(sf::Packet& packet, uint64_t* words) {
+        for (int32_t w = 0; w < WORDS; w++) {
+            sf::Uint64 word;
+            packet >> word;
+            words[w] = word;
+        }
+        return static_cast<bool>(packet);
+    }
+
+    template <bool HASH>
+    void step_range(int32_t r0, int32_t r1, GenerationCounters& counters) {
+        for (int32_t r = r0; r < r1; r++) {
+            const uint64_t* center = row(cells, r);
+            uint64_t* out = row(next_cells, r);
+            for (int32_t w = 0; w < WORDS; w++) {
+                uint64_t cell = center[w];
+                uint64_t result = life_word_step(center + w - STRIDE, center + w, center + w + STRIDE);
+                if (w == WORDS - 1) {
+                    result &= TAIL_MASK;
+                }
+                out[w] = result;
+                counters.population += __builtin_popcountll(result);
+                counters.births += __builtin_popcountll(result & ~cell);
+                counters.deaths += __builtin_popcountll(cell & ~result);
+                if (HASH) {
+                    for (uint64_t diff = result ^ cell; diff != 0; diff &= diff - 1) {
+                        counters.hash_delta ^= zobrist_key(x0 + r, w * 64 + __builtin_ctzll(diff));
+                    }
+                }
+            }
+        }
+    }
+
+    void step_range(int32_t r0, int32_t r1, GenerationCounters& counters) {
+        if (hashing) {
+            step_range<true>(r0, r1, counters);
+        } else {
+            step_range<false>(r0, r1, counters);
+        }
+    }
+
+    // Halo traffic of one generation on the non-blocking neighbour sockets.
+    struct Exchange {
+        sf::Packet to_upper, to_lower, from_upper, from_lower;
+        bool sent_upper, sent_lower, got_upper, got_lower;
+    };
+
+    // Moves the exchange on as far as it will go without waiting. False if
+    // a neighbour is gone.
+    bool poll(Exchange& exchange) {
+        if (!exchange.sent_upper) {
+            sf::Socket::Status status = upper->send(exchange.to_upper);
+            exchange.sent_upper = status == sf::Socket::Done;
+            if (status != sf::Socket::Done && status != sf::Socket::Partial && status != sf::Socket::NotReady) {
+                return false;
+            }
+        }
+        if (!exchange.sent_lower) {
+            sf::Socket::Status status = lower->send(exchange.to_lower);
+            exchange.sent_lower = status == sf::Socket::Done;
+            if (status != sf::Socket::Done && status != sf::Socket::Partial && status != sf::Socket::NotReady) {
+                return false;
+            }
+        }
+        if (!exchange.got_upper) {
+            sf::Socket::Status status = upper->receive(exchange.from_upper);
+            exchange.got_upper = status == sf::Socket::Done;
+            if (status != sf::Socket::Done && status != sf::Socket::NotReady) {
+                return false;
+            }
+        }
+        if (!exchange.got_lower) {
+            sf::Socket::Status status = lower->receive(exchange.from_lower);
+            exchange.got_lower = status == sf::Socket::Done;
+            if (status != sf::Socket::Done && status != sf::Socket::NotReady) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool done(const Exchange& exchange) {
+        return exchange.sent_upper && exchange.sent_lower && exchange.got_upper && exchange.got_lower;
+    }
+
+    // One generation. The edge rows go out first and the interior, which
+    // needs no halo, is stepped while they travel; the edge rows are
+    // stepped once the neighbours' rows are in.
+    bool step(GenerationCounters& counters) {
+        LIFE_TRACE_SCOPE("slab_step");
+        Exchange exchange;
+        exchange.sent_upper = exchange.got_upper = upper == nullptr;
+        exchange.sent_lower = exchange.got_lower = lower == nullptr;
+        if (upper != nullptr) {
+            write_row(exchange.to_upper, row(cells, 0));
+        }
+        if (lower != nullptr) {
+            write_row(exchange.to_lower, row(cells, rows - 1));
+        }
+        for (int32_t r = 1; r < rows - 1; r += POLL_ROWS) {
+            if (!poll(exchange)) {
+                return false;
+            }
+            step_range(r, std::min(rows - 1, r + POLL_ROWS), counters);
+        }
+        while (!done(exchange)) {
+            if (!poll(exchange)) {
+                return false;
+            }
+            if (!done(exchange)) {
+                std::this_thread::yield();
+            }
+        }
+        if (upper != nullptr && !read_row(exchange.from_upper, row(cells, -1))) {
+            return false;
+        }
+        if (lower != nullptr && !read_row(exchange.from_lower, row(cells, rows))) {
+            return false;
+        }
+        step_range(0, 1, counters);
+        if (rows > 1) {
+            step_range(rows - 1, rows, counters);
+        }
+        std::swap(cells, next_cells);
+        return true;
+    }
+
+    // Takes the slab and connects the neighbours.
+    bool assign(sf::Packet& packet) {
+        sf::Uint32 index, count, upper_address;
+        sf::Int32 first, end;
+        sf::Uint16 upper_port;
+        packet >> index >> count >> first >> end >> hashing >> upper_address >> upper_port;
+        if (!packet || first < 0 || end <= first || end > HEIGHT) {
+            return false;
+        }
+        x0 = first;
+        rows = end - first;
+        cells.assign(static_cast<size_t>(rows + 2) * STRIDE, 0);
+        next_cells.assign(static_cast<size_t>(rows + 2) * STRIDE, 0);
+        if (index > 0) {
+            upper = std::make_unique<sf::TcpSocket>();
+            if (upper->connect(sf::IpAddress(upper_address), upper_port) != sf::Socket::Done) {
+                return false;
+            }
+            upper->setBlocking(false);
+        }
+        if (index + 1 < count) {
+            lower = std::make_unique<sf::TcpSocket>();
+            if (listener.accept(*lower) != sf::Socket::Done) {
+                return false;
+            }
+            lower->setBlocking(false);
+        }
+        listener.close();
+        return true;
+    }
+public:
+    // Connects to the coordinator at `host`:`port` and introduces itself.
+    bool connect(const sf::IpAddress& host, unsigned short port) {
+        if (listener.listen(sf::Socket::AnyPort) != sf::Socket::Done) {
+            return false;
+        }
+        if (coordinator.connect(host, port) != sf::Socket::Done) {
+            return false;
+        }
+        sf::Packet hello;
+        hello << static_cast<sf::Uint8>(slab_message::HELLO) << static_cast<sf::Uint16>(listener.getLocalPort());
+        return coordinator.send(hello) == sf::Socket::Done;
+    }
+
+    // Serves the coordinator until it says to quit; false if a connection
+    // fails or a message makes no sense.
+    bool run() {
+        for (;;) {
+            sf::Packet packet;
+            if (coordinator.receive(packet) != sf::Socket::Done) {
+                return false;
+            }
+            sf::Uint8 type;
+            packet >> type;
+            sf::Packet reply;
+            switch (type) {
+            case slab_message::ASSIGN: {
+                bool ok = assign(packet);
+                reply << static_cast<sf::Uint8>(slab_message::READY) << ok;
+                if (coordinator.send(reply) != sf::Socket::Done || !ok) {
+                    return false;
+                }
+                break;
+            }
+            case slab_message::LOAD: {
+                sf::Int32 x;
+                packet >> x;
+                if (!packet || x < x0 || x >= x0 + rows || !read_row(packet, row(cells, x - x0))) {
+                    return false;
+                }
+                break;
+            }
+            case slab_message::STEP: {
+                sf::Int32 generations;
+                packet >> generations;
+                GenerationCounters counters;
+                for (sf::Int32 i = 0; i < generations; i++) {
+                    GenerationCounters one;
+                    if (!step(one)) {
+                        return false;
+                    }
+                    counters.population = one.population;
+                    counters.births += one.births;
+                    counters.deaths += one.deaths;
+                    counters.hash_delta ^= one.hash_delta;
+                }
+                reply << static_cast<sf::Uint8>(slab_message::COUNTERS) << static_cast<sf::Int64>(counters.population)
+                      << static_cast<sf::Int64>(counters.births) << static_cast<sf::Int64>(counters.deaths)
+                      << static_cast<sf::Uint64>(counters.hash_delta);
+                if (coordinator.send(reply) != sf::Socket::Done) {
+                    return false;
+                }
+                break;
+            }
+            case slab_message::SNAPSHOT:
+                for (int32_t r = 0; r < rows; r++) {
+                    sf::Packet out;
+                    out << static_cast<sf::Uint8>(slab_message::ROW) << static_cast<sf::Int32>(x0 + r);
+                    write_row(out, row(cells, r));
+                    if (coordinator.send(out) != sf::Socket::Done) {
+                        return false;
+                    }
+                }
+                break;
+            case slab_message::QUIT:
+                return true;
+            default:
+                return false;
+            }
+        }
+    }
+};
+
+template <int HEIGHT, int WIDTH>
+class SlabCoordinator {
+public:
+    using Grid = BitGrid<HEIGHT, WIDTH>;
+private:
+    sf::TcpListener listener;
+    std::vector< std::unique_ptr<sf::TcpSocket> > workers;
+    bool hashing {false};
+
+    bool send_all(sf::Packet& packet) {
+        for (auto& worker : workers) {
+            if (worker->send(packet) != sf::Socket::Done) {
+                return false;
+            }
+        }
+        return true;
+    }
+public:
+    // Listens for workers; AnyPort picks a free port, see get_port().
+    bool listen(unsigned short port = sf::Socket::AnyPort) {
+        return listener.listen(port) == sf::Socket::Done;
+    }
+
+    unsigned short get_port() const { return listener.getLocalPort(); }
+
+    // Whether the workers report hash deltas; set before accept_workers().
+    void set_hashing(bool val) { hashing = val; }
+
+    // Waits for `count` workers, at most one per row, gives each its slab in
+    // the order they connected and waits until all have their neighbours.
+    bool accept_workers(int32_t count) {
+        if (count < 1 || count > HEIGHT) {
+            return false;
+        }
+        std::vector<sf::Uint16> ports;
+        for (int32_t i = 0; i < count; i++) {
+            auto worker = std::make_unique<sf::TcpSocket>();
+            sf::Packet hello;
+            sf::Uint8 type;
+            sf::Uint16 port;
+            if (listener.accept(*worker) != sf::Socket::Done || worker->receive(hello) != sf::Socket::Done ||
+                !(hello >> type >> port) || type != slab_message::HELLO) {
+                return false;
+            }
+            workers.push_back(std::move(worker));
+            ports.push_back(port);
+        }
+        for (int32_t i = 0; i < count; i++) {
+            int32_t x0, x1;
+            slab_rows(HEIGHT, i, count, x0, x1);
+            sf::Packet assign;
+            assign << static_cast<sf::Uint8>(slab_message::ASSIGN) << static_cast<sf::Uint32>(i)
+                   << static_cast<sf::Uint32>(count) << static_cast<sf::Int32>(x0) << static_cast<sf::Int32>(x1)
+                   << hashing << (i > 0 ? workers[i - 1]->getRemoteAddress().toInteger() : sf::Uint32 {0})
+                   << (i > 0 ? ports[i - 1] : sf::Uint16 {0});
+            if (workers[i]->send(assign) != sf::Socket::Done) {
+                return false;
+            }
+        }
+        for (auto& worker : workers) {
+            sf::Packet ready;
+            sf::Uint8 type;
+            bool ok;
+            if (worker->receive(ready) != sf::Socket::Done || !(ready >> type >> ok) ||
+                type != slab_message::READY || !ok) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int32_t worker_count() const { return static_cast<int32_t>(workers.size()); }
+
+    // Sends every row of `grid` to the worker that owns it.
+    bool load(const Grid& grid) {
+        const int32_t count = worker_count();
+        for (int32_t i = 0; i < count; i++) {
+            int32_t x0, x1;
+            slab_rows(HEIGHT, i, count, x0, x1);
+            for (int32_t x = x0; x < x1; x++) {
+                sf::Packet packet;
+                packet << static_cast<sf::Uint8>(slab_message::LOAD) << static_cast<sf::Int32>(x);
+                const uint64_t* words = grid.row(x);
+                for (int32_t w = 0; w < Grid::WORDS; w++) {
+                    packet << static_cast<sf::Uint64>(words[w]);
+                }
+                if (workers[i]->send(packet) != sf::Socket::Done) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Runs `generations` generations on all workers; counters are combined
+    // the way StepEngine::make_step combines them.
+    bool step(int32_t generations, GenerationCounters& counters) {
+        LIFE_TRACE_SCOPE("slab_coordinator_step");
+        sf::Packet packet;
+        packet << static_cast<sf::Uint8>(slab_message::STEP) << static_cast<sf::Int32>(generations);
+        if (!send_all(packet)) {
+            return false;
+        }
+        counters = GenerationCounters {};
+        for (auto& worker : workers) {
+            sf::Packet reply;
+            sf::Uint8 type;
+            sf::Int64 population, births, deaths;
+            sf::Uint64 hash_delta;
+            if (worker->receive(reply) != sf::Socket::Done ||
+                !(reply >> type >> population >> births >> deaths >> hash_delta) || type != slab_message::COUNTERS) {
+                return false;
+            }
+            counters.population += population;
+            counters.births += births;
+            counters.deaths += deaths;
+            counters.hash_delta ^= hash_delta;
+        }
+        return true;
+    }
+
+    // Collects the whole board from the workers into `grid`.
+    bool gather(Grid& grid) {
+        sf::Packet packet;
+        packet << static_cast<sf::Uint8>(slab_message::SNAPSHOT);
+        if (!send_all(packet)) {
+            return false;
+        }
+        const int32_t count = worker_count();
+        for (int32_t i = 0; i < count; i++) {
+            int32_t x0, x1;
+            slab_rows(HEIGHT, i, count, x0, x1);
+            for (int32_t x = x0; x < x1; x++) {
+                sf::Packet reply;
+                sf::Uint8 type;
+                sf::Int32 row;
+                if (workers[i]->receive(reply) != sf::Socket::Done || !(reply >> type >> row) ||
+                    type != slab_message::ROW || row != x) {
+                    return false;
+                }
+                uint64_t* words = grid.row(x);
+                for (int32_t w = 0; w < Grid::WORDS; w++) {
+                    sf::Uint64 word;
+                    reply >> word;
+                    words[w] = word;
+                }
+                if (!reply) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Tells the workers to exit and drops them.
+    void quit() {
+        sf::Packet packet;
+        packet << static_cast<sf::Uint8>(slab_message::QUIT);
+        send_all(packet);
+        workers.clear();
+    }
+};
+
+#endif // LIFEGAME_SLABNETWORK_H
@@ -0,0 +1,348 @@
+#ifndef LIFEGAME_SOUPSEARCH_H
+#define LIFEGAME_SOUPSEARCH_H
+
+#include <bit_grid.h>
+#include <component_labeller.h>
+#include <cycle_detector.h>
+#include <life_trace.h>
+#include <thread_pool.h>
+#include <zobrist.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Random soup search with an object census, after apgsearch. Soup `id` is a
+// 16x16 block of cells derived from a hash of the string, so any soup in a
+// report can be regenerated from its name, placed in the middle of the board
+// and run until it dies out, freezes or cycles. What is left is split into
+// objects, 8-connected over every phase of the cycle, and each object is
+// stepped on its own to find its period and named by an apgcode-style
+// canonical string: "xs<population>_" for still lifes and "xp<period>_" for
+// oscillators, then the extended Wechsler code of the smallest of its phases
+// and symmetries. Objects that only cycle alongside their neighbours are
+// named "zz_" plus the code of their current phase.
+//
+// The board is bounded, so gliders end up as debris at the edges rather than
+// flying away; boards much larger than the soup keep that rare.
+template <int HEIGHT, int WIDTH>
+class SoupSearch {
+public:
+    using Grid = BitGrid<HEIGHT, WIDTH>;
+    using Detector = CycleDetector<Grid>;
+    using Census = std::map<std::string, uint64_t>;
+    using Cells = std::vector< std::pair<int32_t, int32_t> >;
+
+    static constexpr int32_t SOUP_SIZE = 16;
+
+    struct Report {
+        uint64_t soups {0};
+        uint64_t unsettled {0}; // still running after max_generations
+        double seconds {0};
+        Census census;
+
+        double soups_per_second() const { return seconds > 0 ? soups / seconds : 0; }
+    };
+private:
+    // One thread's buffers for searching soups, reused from soup to soup so
+    // the grids and the labeller are allocated once per thread. The census
+    // map and the cell list still allocate as they grow; nothing is shared
+    // between threads until the censuses are merged.
+    struct Workspace {
+        Grid cur, next, phases, isolated, isolated_next, object;
+        Cells cells;
+        ComponentLabeller<HEIGHT, WIDTH> labeller {1};
+        Census census;
+        uint64_t unsettled {0};
+    };
+
+    uint64_t max_generations {1 << 15};
+    int32_t max_period {64};
+    ThreadPool pool;
+
+    static uint64_t splitmix(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    static void step(const Grid& cur, Grid& next, int32_t x_begin, int32_t x_end, GenerationCounters& counters) {
+        life_step_rows<true>(cur.row(0), next.row(0), Grid::STRIDE, Grid::WORDS, Grid::TAIL_MASK,
+                             std::max(0, x_begin), std::min(HEIGHT, x_end), 0, Grid::WORDS, counters);
+    }
+
+    static void clear_rows(Grid& grid, int32_t x_begin, int32_t x_end) {
+        for (int32_t x = std::max(0, x_begin); x < std::min(HEIGHT, x_end); x++) {
+            std::memset(grid.row(x), 0, Grid::WORDS * sizeof(uint64_t));
+        }
+    }
+
+    static bool same_rows(const Grid& a, const Grid& b, int32_t x_begin, int32_t x_end) {
+        for (int32_t x = std::max(0, x_begin); x < std::min(HEIGHT, x_end); x++) {
+            if (std::memcmp(a.row(x), b.row(x), Grid::WORDS * sizeof(uint64_t)) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Extended Wechsler code of cells normalised to start at (0, 0): strips
+    // of five rows separated by 'z', one character per column of a strip,
+    // with runs of empty columns shortened to w, x or y<n>.
+    static std::string wechsler(const Cells& cells, int32_t height, int32_t width) {
+        static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+        std::vector<uint8_t> columns(static_cast<size_t>((height + 4) / 5) * width, 0);
+        for (const auto& cell : cells) {
+            columns[static_cast<size_t>(cell.first / 5) * width + cell.second] |= 1 << (cell.first % 5);
+        }
+        std::string code;
+        for (int32_t strip = 0; strip * 5 < height; strip++) {
+            if (strip > 0) {
+                code += 'z';
+            }
+            int32_t zeros = 0;
+            for (int32_t y = 0; y < width; y++) {
+                uint8_t column = columns[static_cast<size_t>(strip) * width + y];
+                if (column == 0) {
+                    zeros++;
+                    continue;
+                }
+                while (zeros > 0) {
+                    if (zeros == 1) {
+                        code += '0';
+                        zeros = 0;
+                    } else if (zeros == 2) {
+                        code += 'w';
+                        zeros = 0;
+                    } else if (zeros == 3) {
+                        code += 'x';
+                        zeros = 0;
+                    } else {
+                        int32_t run = std::min(zeros, 39);
+                        code += 'y';
+                        code += digits[run - 4];
+                        zeros -= run;
+                    }
+                }
+                code += digits[column];
+            }
+        }
+        return code;
+    }
+
+    // Smallest code over the 8 rotations and reflections, shorter first.
+    static void canonical_code(const Cells& cells, std::string& best) {
+        for (int32_t symmetry = 0; symmetry < 8; symmetry++) {
+            Cells moved;
+            moved.reserve(cells.size());
+            int32_t min_x = INT32_MAX, min_y = INT32_MAX, max_x = INT32_MIN, max_y = INT32_MIN;
+            for (const auto& cell : cells) {
+                int32_t x = cell.first, y = cell.second;
+                if (symmetry & 4) {
+                    std::swap(x, y);
+                }
+                if (symmetry & 2) {
+                    x = -x;
+                }
+                if (symmetry & 1) {
+                    y = -y;
+                }
+                moved.emplace_back(x, y);
+                min_x = std::min(min_x, x);
+                min_y = std::min(min_y, y);
+                max_x = std::max(max_x, x);
+                max_y = std::max(max_y, y);
+            }
+            for (auto& cell : moved) {
+                cell.first -= min_x;
+                cell.second -= min_y;
+            }
+            std::string code = wechsler(moved, max_x - min_x + 1, max_y - min_y + 1);
+            if (best.empty() || code.size() < best.size() || (code.size() == best.size() && code < best)) {
+                best = code;
+            }
+        }
+    }
+
+    static void collect(const Grid& grid, int32_t x_begin, int32_t x_end, Cells& cells) {
+        cells.clear();
+        for (int32_t x = std::max(0, x_begin); x < std::min(HEIGHT, x_end); x++) {
+            const uint64_t* r = grid.row(x);
+            for (int32_t w = 0; w < Grid::WORDS; w++) {
+                for (uint64_t word = r[w]; word != 0; word &= word - 1) {
+                    cells.emplace_back(x, w * 64 + __builtin_ctzll(word));
+                }
+            }
+        }
+    }
+
+    // Names one object: its cells at the current phase are in workspace.object,
+    // rows [x_begin, x_end) bound it over every phase of the board cycle.
+    std::string classify(Workspace& workspace, int32_t x_begin, int32_t x_end, int32_t board_period) {
+        GenerationCounters counters;
+        int32_t population = 0;
+        for (int32_t x = x_begin; x < x_end; x++) {
+            for (int32_t w = 0; w < Grid::WORDS; w++) {
+                population += __builtin_popcountll(workspace.object.row(x)[w]);
+            }
+        }
+
+        clear_rows(workspace.isolated, x_begin - 1, x_end + 1);
+        clear_rows(workspace.isolated_next, x_begin - 1, x_end + 1);
+        for (int32_t x = x_begin; x < x_end; x++) {
+            std::memcpy(workspace.isolated.row(x), workspace.object.row(x), Grid::WORDS * sizeof(uint64_t));
+        }
+
+        std::string best;
+        int32_t period = 0;
+        for (int32_t p = 1; p <= board_period; p++) {
+            collect(workspace.isolated, x_begin, x_end, workspace.cells);
+            canonical_code(workspace.cells, best);
+            step(workspace.isolated, workspace.isolated_next, x_begin - 1, x_end + 1, counters);
+            std::swap(workspace.isolated, workspace.isolated_next);
+            if (same_rows(workspace.isolated, workspace.object, x_begin - 1, x_end + 1)) {
+                period = p;
+                break;
+            }
+        }
+        clear_rows(workspace.isolated, x_begin - 1, x_end + 1);
+        clear_rows(workspace.isolated_next, x_begin - 1, x_end + 1);
+
+        if (period == 0) {
+            collect(workspace.object, x_begin, x_end, workspace.cells);
+            best.clear();
+            canonical_code(workspace.cells, best);
+            return "zz_" + best;
+        }
+        if (period == 1) {
+            return "xs" + std::to_string(population) + "_" + best;
+        }
+        return "xp" + std::to_string(period) + "_" + best;
+    }
+
+    // Splits the settled board in workspace.cur, cycling with `period`, into
+    // objects and counts them.
+    void census(Workspace& workspace, int32_t period) {
+        // Every cell any phase of the cycle touches.
+        GenerationCounters counters;
+        workspace.phases = workspace.cur;
+        workspace.next = workspace.cur;
+        for (int32_t p = 1; p < period; p++) {
+            step(workspace.next, workspace.isolated, 0, HEIGHT, counters);
+            std::swap(workspace.next, workspace.isolated);
+            for (int32_t x = 0; x < HEIGHT; x++) {
+                for (int32_t w = 0; w < Grid::WORDS; w++) {
+                    workspace.phases.row(x)[w] |= workspace.next.row(x)[w];
+                }
+            }
+        }
+        workspace.isolated.clear();
+
+        for (const auto& component : workspace.labeller.label(workspace.phases)) {
+            const auto* cell = workspace.labeller.get_cells().data() + component.begin;
+            const auto* end = workspace.labeller.get_cells().data() + component.end;
+            for (; cell != end; cell++) {
+                if (workspace.cur.get(cell->first, cell->second)) {
+                    workspace.object.set(cell->first, cell->second, true);
+                }
+            }
+            workspace.census[classify(workspace, component.x_min, component.x_max + 1, period)]++;
+            clear_rows(workspace.object, component.x_min, component.x_max + 1);
+        }
+    }
+
+    void search_soup(Workspace& workspace, const std::string& id) {
+        LIFE_TRACE_SCOPE("soup");
+        workspace.cur.clear();
+        seed(id, workspace.cur);
+        uint64_t hash = 0;
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            for (int32_t w = 0; w < Grid::WORDS; w++) {
+                for (uint64_t word = workspace.cur.row(x)[w]; word != 0; word &= word - 1) {
+                    hash ^= zobrist_key(x, w * 64 + __builtin_ctzll(word));
+                }
+            }
+        }
+
+        Detector detector(max_period);
+        for (uint64_t generation = 1; generation <= max_generations; generation++) {
+            GenerationCounters counters;
+            step(workspace.cur, workspace.next, 0, HEIGHT, counters);
+            std::swap(workspace.cur, workspace.next);
+            hash ^= counters.hash_delta;
+            if (detector.observe(generation, hash, counters.population, [&](Grid& out) { out = workspace.cur; })) {
+                if (detector.get_result().kind != Detector::EXTINCT) {
+                    census(workspace, detector.get_result().period);
+                }
+                return;
+            }
+        }
+        workspace.unsettled++;
+    }
+public:
+    // `threads` counts the calling thread; 0 means one per hardware thread.
+    explicit SoupSearch(size_t threads = 0) : pool(threads) {}
+
+    void set_max_generations(uint64_t generations) { max_generations = generations; }
+    uint64_t get_max_generations() const { return max_generations; }
+    void set_max_period(int32_t period) { max_period = period; }
+    int32_t get_max_period() const { return max_period; }
+    size_t threads() const { return pool.size(); }
+
+    // Writes soup `id` into the middle of an empty grid.
+    static void seed(const std::string& id, Grid& grid) {
+        uint64_t state = 0xCBF29CE484222325ULL; // FNV-1a of the id
+        for (char c : id) {
+            state = (state ^ static_cast<uint8_t>(c)) * 0x100000001B3ULL;
+        }
+        int32_t x0 = std::max(0, (HEIGHT - SOUP_SIZE) / 2);
+        int32_t y0 = std::max(0, (WIDTH - SOUP_SIZE) / 2);
+        for (int32_t x = 0; x < SOUP_SIZE; x += 4) {
+            uint64_t bits = splitmix(state); // four rows of 16
+            for (int32_t i = 0; i < 64; i++) {
+                int32_t cx = x0 + x + i / SOUP_SIZE, cy = y0 + i % SOUP_SIZE;
+                if (((bits >> i) & 1) && cx < HEIGHT && cy < WIDTH) {
+                    grid.set(cx, cy, true);
+                }
+            }
+        }
+    }
+
+    // Searches soups `prefix`0 to `prefix`<count - 1> across the pool. Each
+    // thread pulls soup numbers from a shared counter into its own workspace and
+    // census; the censuses are merged at the end.
+    Report search(const std::string& prefix, uint64_t count) {
+        LIFE_TRACE_SCOPE("soup_search");
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point begin = Clock::now();
+
+        Report report;
+        std::mutex merge;
+        std::atomic<uint64_t> next_soup {0};
+        pool.parallel_for(pool.size(), [&](size_t) {
+            std::unique_ptr<Workspace> workspace = std::make_unique<Workspace>();
+            for (uint64_t soup = next_soup++; soup < count; soup = next_soup++) {
+                search_soup(*workspace, prefix + std::to_string(soup));
+            }
+            std::lock_guard<std::mutex> guard(merge);
+            for (const auto& entry : workspace->census) {
+                report.census[entry.first] += entry.second;
+            }
+            report.unsettled += workspace->unsettled;
+        });
+
+        report.soups = count;
+        report.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        return report;
+    }
+};
+
+#endif // LIFEGAME_SOUPSEARCH_H
@@ -0,0 +1,228 @@
+#ifndef LIFEGAME_SPARSEENGINE_H
+#define LIFEGAME_SPARSEENGINE_H
+
+#include <arena.h>
+#include <step_engine.h>
+#include <zobrist.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Engine for very sparse boards: only live cells are stored, as sorted
+// column lists grouped by row. The next generation is built by sweeping
+// every row that has a live row within one step, merging the three source
+// rows around it, so a step costs O(population) no matter the board size.
+// Cells are two-state; any non-zero id is stored as alive.
+template <int HEIGHT, int WIDTH>
+class SparseEngine : public StepEngine<HEIGHT, WIDTH> {
+public:
+    using Field = typename StepEngine<HEIGHT, WIDTH>::Field;
+
+    struct Row {
+        int32_t x;
+        uint32_t begin; // into cols
+        uint32_t end;
+    };
+    using Rows = std::vector< Row, ArenaAllocator<Row> >;
+    using Cols = std::vector< int32_t, ArenaAllocator<int32_t> >;
+private:
+    Rows rows, next_rows;
+    Cols cols, next_cols;
+
+    typename Rows::const_iterator find_row(int32_t x) const {
+        return std::lower_bound(rows.begin(), rows.end(), x,
+                                [](const Row& row, int32_t val) { return row.x < val; });
+    }
+
+    // Sweeps one output row `x` given the source rows above, at and below it
+    // (any of which may be empty).
+    void step_row(int32_t x, const Row* near[3], GenerationCounters& counters) {
+        uint32_t pos[3], end[3];
+        int32_t first = WIDTH + 2;
+        for (int k = 0; k < 3; k++) {
+            pos[k] = near[k] ? near[k]->begin : 0;
+            end[k] = near[k] ? near[k]->end   : 0;
+            if (pos[k] < end[k]) {
+                first = std::min(first, cols[pos[k]]);
+            }
+        }
+        if (first == WIDTH + 2) {
+            return;
+        }
+
+        uint32_t row_begin = static_cast<uint32_t>(next_cols.size());
+        int32_t y = first - 1;
+        while (true) {
+            int32_t neighbours = 0;
+            bool alive = false;
+            int32_t next_seen = WIDTH + 2;
+            for (int k = 0; k < 3; k++) {
+                while (pos[k] < end[k] && cols[pos[k]] < y - 1) {
+                    pos[k]++;
+                }
+                for (uint32_t i = pos[k]; i < end[k] && cols[i] <= y + 1; i++) {
+                    if (k == 1 && cols[i] == y) {
+                        alive = true;
+                    } else {
+                        neighbours++;
+                    }
+                }
+                for (uint32_t i = pos[k]; i < end[k]; i++) {
+                    if (cols[i] >= y) {
+                        next_seen = std::min(next_seen, cols[i]);
+                        break;
+                    }
+                }
+            }
+
+            if (0 <= y && y < WIDTH) {
+                bool next = neighbours == 3 || (alive && neighbours == 2);
+                if (next) {
+                    next_cols.push_back(y);
+                }
+                counters.births += next && !alive;
+                counters.deaths += alive && !next;
+                if (this->hashing && next != alive) {
+                    counters.hash_delta ^= zobrist_key(x, y);
+                }
+            }
+
+            if (next_seen == WIDTH + 2) {
+                break;
+            }
+            y = next_seen <= y + 2 ? y + 1 : next_seen - 1;
+        }
+
+        uint32_t row_end = static_cast<uint32_t>(next_cols.size());
+        if (row_begin != row_end) {
+            next_rows.push_back(Row {x, row_begin, row_end});
+        }
+    }
+public:
+    const char* name() const override { return "sparse_list"; }
+
+    void clear() override {
+        rows.clear();
+        cols.clear();
+    }
+
+    int32_t get_id(int32_t x, int32_t y) const override {
+        if (!(0 <= x && x < HEIGHT && 0 <= y && y < WIDTH)) {
+            return -1;
+        }
+        auto row = find_row(x);
+        if (row == rows.end() || row->x != x) {
+            return 0;
+        }
+        return std::binary_search(cols.begin() + row->begin, cols.begin() + row->end, y) ? 1 : 0;
+    }
+
+    void set_id(int32_t x, int32_t y, int32_t id) override {
+        if (!(0 <= x && x < HEIGHT && 0 <= y && y < WIDTH)) {
+            return;
+        }
+        // Row-major fill, as load() does, only ever appends.
+        if (id != 0 && (rows.empty() || rows.back().x < x)) {
+            uint32_t at = static_cast<uint32_t>(cols.size());
+            rows.push_back(Row {x, at, at + 1});
+            cols.push_back(y);
+            return;
+        }
+        if (id != 0 && rows.back().x == x && cols.back() < y) {
+            cols.push_back(y);
+            rows.back().end++;
+            return;
+        }
+
+        auto found = std::lower_bound(rows.begin(), rows.end(), x,
+                                      [](const Row& row, int32_t val) { return row.x < val; });
+        size_t index = found - rows.begin();
+        if (found == rows.end() || found->x != x) {
+            if (id == 0) {
+                return;
+            }
+            uint32_t at = found == rows.end() ? static_cast<uint32_t>(cols.size()) : found->begin;
+            rows.insert(found, Row {x, at, at});
+        }
+
+        Row& row = rows[index];
+        auto col = std::lower_bound(cols.begin() + row.begin, cols.begin() + row.end, y);
+        bool present = col != cols.begin() + row.end && *col == y;
+        if ((id != 0) == present) {
+            return;
+        }
+        if (id != 0) {
+            cols.insert(col, y);
+            row.end++;
+            for (size_t i = index + 1; i < rows.size(); i++) {
+                rows[i].begin++;
+                rows[i].end++;
+            }
+        } else {
+            cols.erase(col);
+            row.end--;
+            for (size_t i = index + 1; i < rows.size(); i++) {
+                rows[i].begin--;
+                rows[i].end--;
+            }
+            if (row.begin == row.end) {
+                rows.erase(rows.begin() + index);
+            }
+        }
+    }
+
+    int64_t get_population() const override {
+        return static_cast<int64_t>(cols.size());
+    }
+
+    void step(GenerationCounters& counters) override {
+        counters = GenerationCounters {};
+        next_rows.clear();
+        next_cols.clear();
+
+        size_t i = 0;
+        int32_t x = rows.empty() ? HEIGHT : rows.front().x - 1;
+        while (i < rows.size()) {
+            while (i < rows.size() && rows[i].x < x - 1) {
+                i++;
+            }
+            const Row* near[3] = {nullptr, nullptr, nullptr};
+            for (size_t j = i; j < rows.size() && rows[j].x <= x + 1; j++) {
+                near[rows[j].x - x + 1] = &rows[j];
+            }
+            if (0 <= x && x < HEIGHT) {
+                step_row(x, near, counters);
+            }
+
+            // Next output row with a source row next to it.
+            size_t j = i;
+            while (j < rows.size() && rows[j].x < x) {
+                j++;
+            }
+            if (j == rows.size()) {
+                break;
+            }
+            x = rows[j].x <= x + 2 ? x + 1 : rows[j].x - 1;
+        }
+
+        std::swap(rows, next_rows);
+        std::swap(cols, next_cols);
+        counters.population = static_cast<int64_t>(cols.size());
+    }
+
+    void store(Field& field) const override {
+        for (auto& row : field) {
+            row.fill(0);
+        }
+        for (const Row& row : rows) {
+            for (uint32_t i = row.begin; i < row.end; i++) {
+                field[row.x][cols[i]] = 1;
+            }
+        }
+    }
+
+    const Rows& get_rows() const { return rows; }
+    const Cols& get_cols() const { return cols; }
+};
+
+#endif // LIFEGAME_SPARSEENGINE_H
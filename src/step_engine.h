@@ -0,0 +1,168 @@
+#ifndef LIFEGAME_STEPENGINE_H
+#define LIFEGAME_STEPENGINE_H
+
+#include <life_stats.h>
+#include <zobrist.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+
+// A step engine owns the board in whatever representation suits it and
+// advances it one generation at a time. LifeGame keeps its dense field for
+// drawing and editing and moves the state in and out of an engine through
+// load() and store(), which by default go cell by cell through get_id/set_id.
+template <int HEIGHT, int WIDTH>
+class StepEngine {
+protected:
+    bool hashing {false};
+public:
+    using Field = std::array< std::array<int32_t, WIDTH>, HEIGHT >;
+
+    virtual ~StepEngine() = default;
+
+    // While on, step() also reports the Zobrist hash delta of the step.
+    virtual void set_hashing(bool val) { hashing = val; }
+
+    virtual const char* name() const = 0;
+    virtual void clear() = 0;
+    virtual int32_t get_id(int32_t x, int32_t y) const = 0;
+    virtual void set_id(int32_t x, int32_t y, int32_t id) = 0;
+    virtual int64_t get_population() const = 0;
+
+    // Advances one generation and fills in what the step did.
+    virtual void step(GenerationCounters& counters) = 0;
+
+    // Advances `generations` generations in one call, so engines that can
+    // work on several at once get the chance. Counters cover the whole run:
+    // population after the last generation, births and deaths summed (-1 if
+    // a step did not report them), hash deltas combined, cache lookups summed.
+    virtual void make_step(int32_t generations, GenerationCounters& counters) {
+        counters = GenerationCounters {};
+        for (int32_t i = 0; i < generations; i++) {
+            GenerationCounters one;
+            step(one);
+            counters.population = one.population;
+            counters.births = one.births < 0 || counters.births < 0 ? -1 : counters.births + one.births;
+            counters.deaths = one.deaths < 0 || counters.deaths < 0 ? -1 : counters.deaths + one.deaths;
+            counters.hash_delta ^= one.hash_delta;
+            counters.cache_hits += one.cache_hits;
+            counters.cache_misses += one.cache_misses;
+        }
+    }
+
+    virtual void load(const Field& field) {
+        clear();
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            for (int32_t y = 0; y < WIDTH; y++) {
+                if (field[x][y] != 0) {
+                    set_id(x, y, field[x][y]);
+                }
+            }
+        }
+    }
+
+    virtual void store(Field& field) const {
+        for (int32_t x = 0; x < HEIGHT; x++) {
+            for (int32_t y = 0; y < WIDTH; y++) {
+                field[x][y] = get_id(x, y);
+            }
+        }
+    }
+};
+
+// Counters of the step from `before` to `after`, hash change included, in
+// one pass over both boards; for kernels that do not report their own.
+template <int HEIGHT, int WIDTH>
+void counters_between(const std::array< std::array<int32_t, WIDTH>, HEIGHT >& before,
+                      const std::array< std::array<int32_t, WIDTH>, HEIGHT >& after, GenerationCounters& counters) {
+    int64_t population = 0, births = 0, deaths = 0;
+    uint64_t hash_delta = 0;
+    for (int32_t x = 0; x < HEIGHT; x++) {
+        for (int32_t y = 0; y < WIDTH; y++) {
+            const int32_t cell = before[x][y], next = after[x][y];
+            population += next != 0;
+            if (cell != next) {
+                births += cell == 0;
+                deaths += next == 0;
+                hash_delta ^= zobrist_key(x, y, cell) ^ zobrist_key(x, y, next);
+            }
+        }
+    }
+    counters.population = population;
+    counters.births = births;
+    counters.deaths = deaths;
+    counters.hash_delta = hash_delta;
+}
+
+// Engine over a plain judge function, the same kind LifeGame takes in
+// set_judge_field_function(). Counters are -1 without a counted variant,
+// unless hashing is on: then they are found by comparing the boards, as is
+// the hash change in any case.
+template <int HEIGHT, int WIDTH>
+class JudgeEngine : public StepEngine<HEIGHT, WIDTH> {
+public:
+    using Field = typename StepEngine<HEIGHT, WIDTH>::Field;
+    using Judge = void (*)(const Field&, Field&);
+    using JudgeCounted = void (*)(const Field&, Field&, GenerationCounters&);
+private:
+    const char* engine_name;
+    Judge judge;
+    JudgeCounted judge_counted;
+    std::unique_ptr<Field> field {std::make_unique<Field>()};
+    std::unique_ptr<Field> next_field {std::make_unique<Field>()};
+public:
+    JudgeEngine(const char* name, Judge judge_func, JudgeCounted judge_counted_func = nullptr)
+        : engine_name(name), judge(judge_func), judge_counted(judge_counted_func) {}
+
+    const char* name() const override { return engine_name; }
+
+    void clear() override {
+        for (auto& row : *field) {
+            row.fill(0);
+        }
+    }
+
+    int32_t get_id(int32_t x, int32_t y) const override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            return (*field)[x][y];
+        }
+        return -1;
+    }
+
+    void set_id(int32_t x, int32_t y, int32_t id) override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            (*field)[x][y] = id;
+        }
+    }
+
+    int64_t get_population() const override {
+        int64_t population = 0;
+        for (const auto& row : *field) {
+            for (int32_t cell : row) {
+                population += cell != 0;
+            }
+        }
+        return population;
+    }
+
+    void step(GenerationCounters& counters) override {
+        if (judge_counted != nullptr) {
+            judge_counted(*field, *next_field, counters);
+            counters.hash_delta = this->hashing ? zobrist_delta<HEIGHT, WIDTH>(*field, *next_field) : 0;
+        } else {
+            judge(*field, *next_field);
+            if (this->hashing) {
+                counters_between<HEIGHT, WIDTH>(*field, *next_field, counters);
+            } else {
+                counters.population = counters.births = counters.deaths = -1;
+                counters.hash_delta = 0;
+            }
+        }
+        std::swap(field, next_field);
+    }
+
+    void load(const Field& source) override { *field = source; }
+    void store(Field& target) const override { target = *field; }
+};
+
+#endif // LIFEGAME_STEPENGINE_H
@@ -0,0 +1,139 @@
+#ifndef LIFEGAME_THREADPOOL_H
+#define LIFEGAME_THREADPOOL_H
+
+#include <life_trace.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. parallel_for() hands
+// out indices one at a time from a shared counter, so uneven tasks balance
+// themselves, and the calling thread works alongside the pool until every
+// index is done. for_each_thread() instead runs a task once on every thread,
+// for work that has to stay on the same thread from call to call.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(size_t)>* task {nullptr};
+    size_t count {0};
+    std::atomic<size_t> next_index {0};
+    size_t busy {0};
+    uint64_t epoch {0};
+    bool per_thread {false};
+    bool stopping {false};
+
+    void drain() {
+        while (true) {
+            size_t i = next_index.fetch_add(1, std::memory_order_relaxed);
+            if (i >= count) {
+                return;
+            }
+            (*task)(i);
+        }
+    }
+
+    void worker_loop(size_t id) {
+        LifeTrace::set_thread_name("worker " + std::to_string(id));
+        uint64_t seen = 0;
+        while (true) {
+            bool each;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                wake.wait(guard, [&] { return stopping || epoch != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = epoch;
+                each = per_thread;
+            }
+            if (each) {
+                (*task)(id);
+            } else {
+                drain();
+            }
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (--busy == 0) {
+                    done.notify_all();
+                }
+            }
+        }
+    }
+public:
+    // `threads` counts the calling thread; 0 means one per hardware thread.
+    explicit ThreadPool(size_t threads = 0) {
+        if (threads == 0) {
+            threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        for (size_t i = 1; i < threads; i++) {
+            workers.emplace_back(&ThreadPool::worker_loop, this, i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    // Runs fn(0) ... fn(n - 1) across the pool and returns when all are done.
+    void parallel_for(size_t n, const std::function<void(size_t)>& fn) {
+        if (n == 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            task = &fn;
+            count = n;
+            next_index.store(0, std::memory_order_relaxed);
+            busy = workers.size();
+            epoch++;
+        }
+        wake.notify_all();
+        drain();
+        std::unique_lock<std::mutex> guard(lock);
+        done.wait(guard, [&] { return busy == 0; });
+        task = nullptr;
+    }
+
+    // Runs fn(id) once on each thread, id 0 being the caller and 1 to
+    // size() - 1 the workers, and returns when all are done.
+    void for_each_thread(const std::function<void(size_t)>& fn) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            task = &fn;
+            per_thread = true;
+            busy = workers.size();
+            epoch++;
+        }
+        wake.notify_all();
+        fn(0);
+        std::unique_lock<std::mutex> guard(lock);
+        done.wait(guard, [&] { return busy == 0; });
+        task = nullptr;
+        per_thread = false;
+    }
+};
+
+#endif // LIFEGAME_THREADPOOL_H
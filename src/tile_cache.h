@@ -0,0 +1,164 @@
+#ifndef LIFEGAME_TILECACHE_H
+#define LIFEGAME_TILECACHE_H
+
+#include <bit_grid.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Least-recently-used cache of Life transitions of 8x8 tiles. The key is the
+// tile with its one-cell border, 10 rows of 10 bits; the value is the next
+// generation of the 8x8 interior, row r in bits 8r to 8r + 7. Keys are stored
+// whole, so a hit is never wrong. Entries sit in one pool sized from the
+// memory cap, chained from a bucket index and threaded on a recency list, so
+// nothing is allocated after construction and a full cache evicts the entry
+// used longest ago.
+class TileCache {
+public:
+    struct Key {
+        uint64_t lo {0}, hi {0};   // rows 0-5 / 6-9, 10 bits each
+        bool operator==(const Key& other) const { return lo == other.lo && hi == other.hi; }
+    };
+
+    struct Stats {
+        uint64_t hits {0};
+        uint64_t misses {0};
+        uint64_t evictions {0};
+        double hit_rate() const {
+            uint64_t lookups = hits + misses;
+            return lookups != 0 ? static_cast<double>(hits) / lookups : 0.0;
+        }
+    };
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Entry {
+        Key key;
+        uint64_t next;
+        uint32_t chain;          // next entry in the same bucket
+        uint32_t older, newer;   // recency list
+    };
+
+    std::vector<Entry> entries;
+    std::vector<uint32_t> buckets;
+    size_t used {0};
+    uint32_t newest {NONE}, oldest {NONE};
+    Stats stats;
+
+    size_t bucket_of(const Key& key) const {
+        uint64_t mixed = key.lo * 0x9E3779B97F4A7C15ULL ^ (key.hi + 0x632BE59BD9B4E019ULL) * 0xBF58476D1CE4E5B9ULL;
+        return static_cast<size_t>((mixed ^ (mixed >> 31)) & (buckets.size() - 1));
+    }
+
+    void unlink(uint32_t i) {
+        Entry& entry = entries[i];
+        (entry.older != NONE ? entries[entry.older].newer : oldest) = entry.newer;
+        (entry.newer != NONE ? entries[entry.newer].older : newest) = entry.older;
+    }
+
+    void push_newest(uint32_t i) {
+        entries[i].older = newest;
+        entries[i].newer = NONE;
+        (newest != NONE ? entries[newest].newer : oldest) = i;
+        newest = i;
+    }
+
+    void remove_from_bucket(uint32_t i) {
+        uint32_t* link = &buckets[bucket_of(entries[i].key)];
+        while (*link != i) {
+            link = &entries[*link].chain;
+        }
+        *link = entries[i].chain;
+    }
+public:
+    // Bytes one entry costs, index included.
+    static constexpr size_t ENTRY_BYTES = sizeof(Entry) + 2 * sizeof(uint32_t);
+
+    // Holds as many entries as fit in `max_bytes`, at least one.
+    explicit TileCache(size_t max_bytes) {
+        size_t capacity = max_bytes / ENTRY_BYTES;
+        capacity = capacity < 1 ? 1 : capacity;
+        size_t bucket_count = 1;
+        while (bucket_count < capacity) {
+            bucket_count *= 2;
+        }
+        entries.resize(capacity);
+        buckets.assign(bucket_count, NONE);
+    }
+
+    static Key make_key(const uint16_t rows[10]) {
+        Key key;
+        for (int32_t r = 0; r < 6; r++) {
+            key.lo |= static_cast<uint64_t>(rows[r]) << (10 * r);
+        }
+        for (int32_t r = 6; r < 10; r++) {
+            key.hi |= static_cast<uint64_t>(rows[r]) << (10 * (r - 6));
+        }
+        return key;
+    }
+
+    // The 8x8 interior one generation on, worked out directly.
+    static uint64_t next_interior(const uint16_t rows[10]) {
+        uint64_t next = 0;
+        for (int32_t r = 1; r <= 8; r++) {
+            uint64_t a = rows[r - 1], c = rows[r], b = rows[r + 1];
+            uint64_t result = life_lanes_step(a << 1, a, a >> 1, b << 1, b, b >> 1, c << 1, c >> 1, c);
+            next |= ((result >> 1) & 0xFF) << (8 * (r - 1));
+        }
+        return next;
+    }
+
+    // Looks `key` up and on a hit marks it most recently used.
+    bool find(const Key& key, uint64_t& next) {
+        for (uint32_t i = buckets[bucket_of(key)]; i != NONE; i = entries[i].chain) {
+            if (entries[i].key == key) {
+                if (i != newest) {
+                    unlink(i);
+                    push_newest(i);
+                }
+                next = entries[i].next;
+                stats.hits++;
+                return true;
+            }
+        }
+        stats.misses++;
+        return false;
+    }
+
+    // Adds a key find() just missed, evicting the least recently used entry
+    // if the cache is full.
+    void insert(const Key& key, uint64_t next) {
+        uint32_t i;
+        if (used < entries.size()) {
+            i = static_cast<uint32_t>(used++);
+        } else {
+            i = oldest;
+            unlink(i);
+            remove_from_bucket(i);
+            stats.evictions++;
+        }
+        Entry& entry = entries[i];
+        entry.key = key;
+        entry.next = next;
+        uint32_t& head = buckets[bucket_of(key)];
+        entry.chain = head;
+        head = i;
+        push_newest(i);
+    }
+
+    size_t size() const { return used; }
+    size_t capacity() const { return entries.size(); }
+    size_t memory_bytes() const { return entries.size() * sizeof(Entry) + buckets.size() * sizeof(uint32_t); }
+
+    const Stats& get_stats() const { return stats; }
+    void reset_stats() { stats = Stats {}; }
+
+    void clear() {
+        used = 0;
+        newest = oldest = NONE;
+        std::fill(buckets.begin(), buckets.end(), NONE);
+    }
+};
+
+#endif // LIFEGAME_TILECACHE_H
@@ -0,0 +1,366 @@
+#ifndef LIFEGAME_TILEDENGINE_H
+#define LIFEGAME_TILEDENGINE_H
+
+#include <bit_grid.h>
+#include <bitwise_engine.h>
+#include <life_trace.h>
+#include <step_engine.h>
+#include <tile_cache.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Bit-packed engine that only steps tiles near activity. The board is cut
+// into tiles of 64 rows by one word; a tile is stepped only if it or one of
+// its eight neighbours changed in the previous generation. A tile that did
+// not change holds the same cells in both buffers, so skipping it costs
+// nothing, and boards that have settled into still lifes step almost free.
+//
+// With a temporal depth k above 1, make_step() works in passes of k
+// generations. A pass copies a block of tiles plus a k-cell halo into a small
+// buffer that stays in cache, steps it k times there, the valid region
+// shrinking by a cell a generation, and writes back only the block itself.
+// The board then goes through memory once per k generations instead of once
+// per generation, at the price of recomputing the halo. The halo is at most
+// one tile deep, so skipping a tile whose neighbours did not change over the
+// last pass stays exact.
+//
+// With a tile cache set, step() looks each 8x8 piece of a tile up by its
+// contents plus border before computing it, which pays off on boards where
+// the same small debris recurs. Hit rates go to the trace as a counter.
+template <int HEIGHT, int WIDTH>
+class TiledEngine : public StepEngine<HEIGHT, WIDTH> {
+public:
+    using Grid = BitGrid<HEIGHT, WIDTH>;
+    static constexpr int32_t TILE_ROWS = 64;
+    static constexpr int32_t TILES_X = (HEIGHT + TILE_ROWS - 1) / TILE_ROWS;
+    static constexpr int32_t TILES_Y = Grid::WORDS;
+    // A halo of more than a tile would reach tiles the skip test ignores.
+    static constexpr int32_t MAX_DEPTH = 64;
+    // Tiles across per temporal block, plus a halo word on either side.
+    static constexpr int32_t BLOCK_WORDS = 16;
+private:
+    static constexpr int32_t BLOCK_STRIDE = BLOCK_WORDS + 4;
+
+    Grid grid, next_grid;
+    std::vector<uint8_t> changed, next_changed;
+    std::vector<int64_t> tile_population;
+    // Per-tile births and deaths of the last pass, replayed when a tile is
+    // skipped: it would have gone through the same generations again.
+    std::vector<int64_t> tile_births, tile_deaths;
+    int64_t active_tiles {0};
+    int32_t depth {1};
+    int32_t last_pass {1};   // generations per pass last time
+    std::vector<uint64_t> block, next_block;
+    std::unique_ptr<TileCache> cache;
+
+    static int32_t tile_of(int32_t x, int32_t y) {
+        return (x / TILE_ROWS) * TILES_Y + (y >> 6);
+    }
+
+    bool neighbourhood_changed(int32_t tx, int32_t ty) const {
+        for (int32_t i = tx - 1; i <= tx + 1; i++) {
+            for (int32_t j = ty - 1; j <= ty + 1; j++) {
+                if (0 <= i && i < TILES_X && 0 <= j && j < TILES_Y && changed[i * TILES_Y + j]) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Steps one tile, rows [x_begin, x_end) of word w, 8x8 at a time through
+    // the cache. Empty pieces stay empty without a lookup.
+    template <bool HASH>
+    bool step_tile_cached(int32_t x_begin, int32_t x_end, int32_t w, GenerationCounters& counters) {
+        uint64_t changed = 0;
+        for (int32_t x0 = x_begin; x0 < x_end; x0 += 8) {
+            // v[r] bit k is column 64 * w + k - 1 of row x0 - 1 + r, so piece
+            // j reads bits 8j to 8j + 9; the two past the word are in spill.
+            uint64_t v[10], spill[10];
+            for (int32_t r = 0; r < 10; r++) {
+                // Rows past the bottom padding row read it again; it is all zero.
+                const uint64_t* row = grid.row(std::min(x0 - 1 + r, HEIGHT));
+                v[r] = (row[w] << 1) | (row[w - 1] >> 63);
+                spill[r] = (row[w] >> 63) | ((row[w + 1] & 1) << 1);
+            }
+            uint64_t out[8] = {};
+            for (int32_t j = 0; j < 8; j++) {
+                uint16_t rows[10];
+                uint16_t any = 0;
+                for (int32_t r = 0; r < 10; r++) {
+                    uint64_t bits = j < 7 ? v[r] >> (8 * j) : (v[r] >> 56) | (spill[r] << 8);
+                    rows[r] = static_cast<uint16_t>(bits & 0x3FF);
+                    any |= rows[r];
+                }
+                if (any == 0) {
+                    continue;
+                }
+                TileCache::Key key = TileCache::make_key(rows);
+                uint64_t next;
+                if (!cache->find(key, next)) {
+                    next = TileCache::next_interior(rows);
+                    cache->insert(key, next);
+                }
+                for (int32_t i = 0; i < 8; i++) {
+                    out[i] |= ((next >> (8 * i)) & 0xFF) << (8 * j);
+                }
+            }
+            for (int32_t i = 0; i < 8 && x0 + i < x_end; i++) {
+                const int32_t x = x0 + i;
+                uint64_t cell = grid.row(x)[w];
+                uint64_t result = w == Grid::WORDS - 1 ? out[i] & Grid::TAIL_MASK : out[i];
+                next_grid.row(x)[w] = result;
+                changed |= result ^ cell;
+                if (HASH) {
+                    for (uint64_t diff = result ^ cell; diff != 0; diff &= diff - 1) {
+                        counters.hash_delta ^= zobrist_key(x, w * 64 + __builtin_ctzll(diff));
+                    }
+                }
+                counters.population += __builtin_popcountll(result);
+                counters.births += __builtin_popcountll(result & ~cell);
+                counters.deaths += __builtin_popcountll(cell & ~result);
+            }
+        }
+        return changed != 0;
+    }
+
+    // Skipping a tile is only exact against a pass of the same length.
+    void begin_pass(int32_t generations) {
+        if (generations != last_pass) {
+            std::fill(changed.begin(), changed.end(), 1);
+            last_pass = generations;
+        }
+    }
+
+    // Word w of board row x in a block buffer whose block starts at row x0
+    // and word w0, for a pass of k generations.
+    static uint64_t* block_at(std::vector<uint64_t>& buffer, int32_t x0, int32_t w0, int32_t k,
+                              int32_t x, int32_t w) {
+        return buffer.data() + static_cast<size_t>(x - x0 + k + 1) * BLOCK_STRIDE + (w - w0 + 2);
+    }
+
+    // Steps tile row tx, tiles [w0, w1) of it, k generations into next_grid.
+    // Rows and words past the board are never stepped, so they stay dead;
+    // halo cells go stale from the outside in, a cell per generation, and
+    // never reach the block.
+    template <bool HASH>
+    void step_block(int32_t tx, int32_t w0, int32_t w1, int32_t k, GenerationCounters& counters) {
+        const int32_t x0 = tx * TILE_ROWS;
+        const int32_t x1 = std::min(HEIGHT, x0 + TILE_ROWS);
+        const int32_t copy_begin = std::max(-1, w0 - 2), copy_end = std::min(Grid::WORDS + 1, w1 + 2);
+        for (int32_t x = std::max(-1, x0 - k - 1); x <= std::min(HEIGHT, x1 + k); x++) {
+            const uint64_t* src = grid.row(x) + copy_begin;
+            const size_t count = static_cast<size_t>(copy_end - copy_begin);
+            std::copy(src, src + count, block_at(block, x0, w0, k, x, copy_begin));
+            std::copy(src, src + count, block_at(next_block, x0, w0, k, x, copy_begin));
+        }
+        const int32_t step_begin = std::max(0, w0 - 1), step_end = std::min(Grid::WORDS, w1 + 1);
+        int64_t births[BLOCK_WORDS] = {}, deaths[BLOCK_WORDS] = {};
+        for (int32_t g = 1; g <= k; g++) {
+            const int32_t x_begin = std::max(0, x0 - (k - g)), x_end = std::min(HEIGHT, x1 + (k - g));
+            for (int32_t x = x_begin; x < x_end; x++) {
+                const uint64_t* center = block_at(block, x0, w0, k, x, w0);
+                uint64_t* out = block_at(next_block, x0, w0, k, x, w0);
+                const bool inside = x0 <= x && x < x1;
+                for (int32_t w = step_begin; w < step_end; w++) {
+                    const uint64_t* at = center + (w - w0);
+                    uint64_t cell = *at;
+                    uint64_t result = life_word_step(at - BLOCK_STRIDE, at, at + BLOCK_STRIDE);
+                    if (w == Grid::WORDS - 1) {
+                        result &= Grid::TAIL_MASK;
+                    }
+                    out[w - w0] = result;
+                    if (inside && w0 <= w && w < w1) {
+                        births[w - w0] += __builtin_popcountll(result & ~cell);
+                        deaths[w - w0] += __builtin_popcountll(cell & ~result);
+                        if (HASH) {
+                            for (uint64_t diff = result ^ cell; diff != 0; diff &= diff - 1) {
+                                counters.hash_delta ^= zobrist_key(x, w * 64 + __builtin_ctzll(diff));
+                            }
+                        }
+                    }
+                }
+            }
+            std::swap(block, next_block);
+        }
+        for (int32_t w = w0; w < w1; w++) {
+            const int32_t t = tx * TILES_Y + w;
+            uint64_t diff = 0;
+            int64_t population = 0;
+            for (int32_t x = x0; x < x1; x++) {
+                uint64_t result = *block_at(block, x0, w0, k, x, w);
+                diff |= result ^ grid.row(x)[w];
+                next_grid.row(x)[w] = result;
+                population += __builtin_popcountll(result);
+            }
+            next_changed[t] = diff != 0;
+            tile_population[t] = population;
+            tile_births[t] = births[w - w0];
+            tile_deaths[t] = deaths[w - w0];
+            active_tiles++;
+        }
+    }
+
+    // One pass of k generations over every block with a tile that needs it.
+    void temporal_pass(int32_t k, GenerationCounters& counters) {
+        begin_pass(k);
+        counters = GenerationCounters {};
+        active_tiles = 0;
+        // step_block() copies in every word it reads, so no clearing.
+        block.resize(static_cast<size_t>(TILE_ROWS + 2 * k + 2) * BLOCK_STRIDE);
+        next_block.resize(block.size());
+        for (int32_t tx = 0; tx < TILES_X; tx++) {
+            for (int32_t w0 = 0; w0 < TILES_Y; w0 += BLOCK_WORDS) {
+                const int32_t w1 = std::min(TILES_Y, w0 + BLOCK_WORDS);
+                bool needed = false;
+                for (int32_t ty = w0; ty < w1 && !needed; ty++) {
+                    needed = neighbourhood_changed(tx, ty);
+                }
+                if (needed) {
+                    if (this->hashing) {
+                        step_block<true>(tx, w0, w1, k, counters);
+                    } else {
+                        step_block<false>(tx, w0, w1, k, counters);
+                    }
+                } else {
+                    for (int32_t ty = w0; ty < w1; ty++) {
+                        next_changed[tx * TILES_Y + ty] = 0;
+                    }
+                }
+                for (int32_t ty = w0; ty < w1; ty++) {
+                    const int32_t t = tx * TILES_Y + ty;
+                    counters.population += tile_population[t];
+                    counters.births += tile_births[t];
+                    counters.deaths += tile_deaths[t];
+                }
+            }
+        }
+        std::swap(grid, next_grid);
+        std::swap(changed, next_changed);
+    }
+public:
+    TiledEngine()
+        : changed(TILES_X * TILES_Y, 1), next_changed(TILES_X * TILES_Y, 0),
+          tile_population(TILES_X * TILES_Y, 0), tile_births(TILES_X * TILES_Y, 0),
+          tile_deaths(TILES_X * TILES_Y, 0) {}
+
+    const char* name() const override { return "tiled"; }
+
+    void clear() override {
+        grid.clear();
+        next_grid.clear();
+        std::fill(changed.begin(), changed.end(), 1);
+    }
+
+    int32_t get_id(int32_t x, int32_t y) const override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            return grid.get(x, y);
+        }
+        return -1;
+    }
+
+    void set_id(int32_t x, int32_t y, int32_t id) override {
+        if (0 <= x && x < HEIGHT && 0 <= y && y < WIDTH) {
+            grid.set(x, y, id != 0);
+            changed[tile_of(x, y)] = 1;
+        }
+    }
+
+    int64_t get_population() const override { return grid.population(); }
+
+    // Generations per make_step() pass; 1 turns temporal blocking off.
+    void set_temporal_depth(int32_t val) { depth = std::min(std::max(val, 1), MAX_DEPTH); }
+    int32_t get_temporal_depth() const { return depth; }
+
+    // Looks 8x8 pieces up in an LRU cache of at most `max_bytes` in step();
+    // 0 turns the cache off.
+    void set_tile_cache(size_t max_bytes) {
+        cache = max_bytes != 0 ? std::make_unique<TileCache>(max_bytes) : nullptr;
+    }
+    const TileCache* get_tile_cache() const { return cache.get(); }
+
+    // Lookups since the cache was set; step() also reports its own in the
+    // counters. All zero without a cache.
+    TileCache::Stats get_cache_stats() const { return cache != nullptr ? cache->get_stats() : TileCache::Stats {}; }
+
+    void step(GenerationCounters& counters) override {
+        begin_pass(1);
+        counters = GenerationCounters {};
+        active_tiles = 0;
+        const TileCache::Stats before = cache != nullptr ? cache->get_stats() : TileCache::Stats {};
+        for (int32_t tx = 0; tx < TILES_X; tx++) {
+            int32_t x_begin = tx * TILE_ROWS;
+            int32_t x_end = std::min(HEIGHT, x_begin + TILE_ROWS);
+            for (int32_t ty = 0; ty < TILES_Y; ty++) {
+                int32_t t = tx * TILES_Y + ty;
+                if (!neighbourhood_changed(tx, ty)) {
+                    next_changed[t] = 0;
+                    counters.population += tile_population[t];
+                    continue;
+                }
+                GenerationCounters tile;
+                if (cache != nullptr) {
+                    next_changed[t] = this->hashing ? step_tile_cached<true>(x_begin, x_end, ty, tile)
+                                                    : step_tile_cached<false>(x_begin, x_end, ty, tile);
+                } else if (this->hashing) {
+                    next_changed[t] = BitwiseEngine<HEIGHT, WIDTH>::template step_region<true>(
+                        grid, next_grid, x_begin, x_end, ty, ty + 1, tile);
+                } else {
+                    next_changed[t] = BitwiseEngine<HEIGHT, WIDTH>::template step_region<false>(
+                        grid, next_grid, x_begin, x_end, ty, ty + 1, tile);
+                }
+                tile_population[t] = tile.population;
+                counters.population += tile.population;
+                counters.births += tile.births;
+                counters.deaths += tile.deaths;
+                counters.hash_delta ^= tile.hash_delta;
+                active_tiles++;
+            }
+        }
+        std::swap(grid, next_grid);
+        std::swap(changed, next_changed);
+        if (cache != nullptr) {
+            TileCache::Stats step_stats = cache->get_stats();
+            step_stats.hits -= before.hits;
+            step_stats.misses -= before.misses;
+            counters.cache_hits = static_cast<int64_t>(step_stats.hits);
+            counters.cache_misses = static_cast<int64_t>(step_stats.misses);
+            LIFE_TRACE_COUNTER("tile_cache_hit_rate", step_stats.hit_rate());
+            LIFE_TRACE_COUNTER("tile_cache_entries", static_cast<double>(cache->size()));
+        }
+    }
+
+    void make_step(int32_t generations, GenerationCounters& counters) override {
+        if (depth == 1) {
+            StepEngine<HEIGHT, WIDTH>::make_step(generations, counters);
+            return;
+        }
+        counters = GenerationCounters {};
+        for (int32_t done = 0; done < generations; ) {
+            const int32_t k = std::min(depth, generations - done);
+            GenerationCounters pass;
+            if (k == 1) {
+                step(pass);
+            } else {
+                temporal_pass(k, pass);
+            }
+            counters.population = pass.population;
+            counters.births += pass.births;
+            counters.deaths += pass.deaths;
+            counters.hash_delta ^= pass.hash_delta;
+            counters.cache_hits += pass.cache_hits;
+            counters.cache_misses += pass.cache_misses;
+            done += k;
+        }
+    }
+
+    // Tiles stepped by the last generation.
+    int64_t get_active_tiles() const { return active_tiles; }
+
+    const Grid& get_grid() const { return grid; }
+};
+
+#endif // LIFEGAME_TILEDENGINE_H
@@ -0,0 +1,48 @@
+#ifndef LIFEGAME_ZOBRIST_H
+#define LIFEGAME_ZOBRIST_H
+
+#include <array>
+#include <cstdint>
+
+// Zobrist hashing of boards: the hash is the xor of one key per live cell, so
+// a step updates it with the keys of the cells that changed. Keys are mixed
+// from the coordinates on the fly rather than kept in a table the size of
+// the board. Dead cells (id 0) have key 0.
+inline uint64_t zobrist_key(int32_t x, int32_t y, int32_t id = 1) {
+    if (id == 0) {
+        return 0;
+    }
+    uint64_t z = ((static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y))
+               + static_cast<uint64_t>(static_cast<uint32_t>(id)) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+template <int HEIGHT, int WIDTH>
+uint64_t zobrist_hash(const std::array< std::array<int32_t, WIDTH>, HEIGHT >& field) {
+    uint64_t hash = 0;
+    for (int32_t x = 0; x < HEIGHT; x++) {
+        for (int32_t y = 0; y < WIDTH; y++) {
+            hash ^= zobrist_key(x, y, field[x][y]);
+        }
+    }
+    return hash;
+}
+
+// Hash change between two boards, for kernels that cannot track it themselves.
+template <int HEIGHT, int WIDTH>
+uint64_t zobrist_delta(const std::array< std::array<int32_t, WIDTH>, HEIGHT >& before,
+                       const std::array< std::array<int32_t, WIDTH>, HEIGHT >& after) {
+    uint64_t delta = 0;
+    for (int32_t x = 0; x < HEIGHT; x++) {
+        for (int32_t y = 0; y < WIDTH; y++) {
+            if (before[x][y] != after[x][y]) {
+                delta ^= zobrist_key(x, y, before[x][y]) ^ zobrist_key(x, y, after[x][y]);
+            }
+        }
+    }
+    return delta;
+}
+
+#endif // LIFEGAME_ZOBRIST_H
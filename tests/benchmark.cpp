@@ -0,0 +1,533 @@
+#include <life_game.h>
+#include <life_patterns.h>
+#include <adaptive_engine.h>
+#include <banded_engine.h>
+#include <bitwise_engine.h>
+#include <block_lookup_engine.h>
+#include <generations_engine.h>
+#include <larger_than_life_engine.h>
+#include <lenia_engine.h>
+#include <mapped_engine.h>
+#include <multi_universe.h>
+#include <sparse_engine.h>
+#include <step_engine.h>
+#include <tiled_engine.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Step throughput benchmark: every engine on every workload over a sweep of
+// board sizes. Prints a table and optionally writes the results as JSON.
+// Engines that step Life are checked against the judge kernel: final board,
+// counters and, over a few more generations, the hash. Exits with 1 if any
+// of them disagrees.
+//
+//   benchmark [--json FILE] [--reps N] [--warmup N] [--budget CELLS]
+
+struct BenchOptions {
+    int32_t reps         {5};
+    int32_t warmup       {10};
+    int64_t budget       {1 << 24}; // cell updates per repetition
+    const char* json     {nullptr};
+};
+
+struct BenchResult {
+    std::string engine;
+    std::string workload;
+    int32_t height;
+    int32_t width;
+    int32_t generations;
+    int32_t reps;
+    double mean_sec;    // per generation
+    double min_sec;
+    double max_sec;
+    double stddev_sec;
+    int64_t population; // after the last repetition
+    std::vector<int64_t> node_pages; // banded only: board pages per NUMA node
+    int64_t unplaced_pages {0};
+    int64_t cache_hits {0};          // tile cache lookups over the last repetition
+    int64_t cache_misses {0};
+};
+
+template <int HEIGHT, int WIDTH>
+using BenchField = std::array< std::array<int32_t, WIDTH>, HEIGHT >;
+
+template <int HEIGHT, int WIDTH>
+struct BenchEngine {
+    const char* name;
+    std::unique_ptr< StepEngine<HEIGHT, WIDTH> > (*make)();
+    bool life; // steps B3/S23, so it is checked against the judge kernel
+};
+
+// Generations stepped with hashing on after the timed run, to check the hash.
+static constexpr int32_t HASH_CHECK_GENERATIONS = 4;
+
+struct BenchWorkload {
+    const char* name;
+    LifePatterns::Cells (*make)(int32_t height, int32_t width);
+};
+
+static LifePatterns::Cells soup_workload(int32_t height, int32_t width) {
+    return LifePatterns::random_soup(height, width, 0.5, 20240601);
+}
+static LifePatterns::Cells r_pentomino_workload(int32_t height, int32_t width) {
+    return LifePatterns::r_pentomino(height / 2 - 1, width / 2 - 1);
+}
+static LifePatterns::Cells acorn_workload(int32_t height, int32_t width) {
+    return LifePatterns::acorn(height / 2 - 1, width / 2 - 3);
+}
+static LifePatterns::Cells gosper_gun_workload(int32_t, int32_t) {
+    return LifePatterns::gosper_glider_gun(1, 1);
+}
+static LifePatterns::Cells breeder_workload(int32_t height, int32_t width) {
+    return LifePatterns::gun_breeder(height, width);
+}
+static LifePatterns::Cells still_life_workload(int32_t height, int32_t width) {
+    return LifePatterns::still_life_field(height, width);
+}
+
+static const BenchWorkload workloads[] = {
+    { "soup50",       soup_workload        },
+    { "r_pentomino",  r_pentomino_workload },
+    { "acorn",        acorn_workload       },
+    { "gosper_gun",   gosper_gun_workload  },
+    { "breeder",      breeder_workload     },
+    { "still_lifes",  still_life_workload  },
+};
+
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_judge_engine() {
+    return std::make_unique< JudgeEngine<HEIGHT, WIDTH> >(
+        "life_game_judge", LifeGame<HEIGHT, WIDTH>::Rules::life_game_judge);
+}
+
+// The kernel as LifeGame runs it with stats enabled, to keep an eye on the
+// cost of counting births and deaths.
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_counted_judge_engine() {
+    return std::make_unique< JudgeEngine<HEIGHT, WIDTH> >(
+        "life_game_judge+counters", LifeGame<HEIGHT, WIDTH>::Rules::life_game_judge,
+        LifeGame<HEIGHT, WIDTH>::Rules::life_game_judge_counted);
+}
+
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_sparse_engine() {
+    return std::make_unique< SparseEngine<HEIGHT, WIDTH> >();
+}
+
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_bitwise_engine() {
+    return std::make_unique< BitwiseEngine<HEIGHT, WIDTH> >();
+}
+
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_tiled_engine() {
+    return std::make_unique< TiledEngine<HEIGHT, WIDTH> >();
+}
+
+// One pinned worker stepping the whole board as its band: the cost of the
+// hand-off to the pool over plain bitwise.
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_banded_engine() {
+    return std::make_unique< BandedEngine<HEIGHT, WIDTH> >(1);
+}
+
+// Life through the 4x4 -> 2x2 table, the portable kernel without adder logic.
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_block_lookup_engine() {
+    return std::make_unique< BlockLookupEngine<HEIGHT, WIDTH> >();
+}
+
+// 8x8 pieces looked up in a 16 MB LRU cache before they are computed.
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_cached_tiled_engine() {
+    auto engine = std::make_unique< TiledEngine<HEIGHT, WIDTH> >();
+    engine->set_tile_cache(16 << 20);
+    return engine;
+}
+
+// Eight generations per pass over each block of tiles.
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_temporal_tiled_engine() {
+    auto engine = std::make_unique< TiledEngine<HEIGHT, WIDTH> >();
+    engine->set_temporal_depth(8);
+    return engine;
+}
+
+// Where the mapped engine keeps its board; bench_size() removes it when done.
+std::string mapped_board_path() {
+    std::error_code error;
+    std::filesystem::path dir = std::filesystem::temp_directory_path(error);
+    return (error ? std::filesystem::path() : dir / "lifegame_benchmark_board.bin").string();
+}
+
+// The board in a file in the temporary directory, paged through a band at a
+// time; with the file in the page cache this measures the engine's overhead
+// over the in-memory kernels rather than the disk. Null if the file cannot
+// be mapped, which skips the engine.
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_mapped_engine() {
+    auto engine = std::make_unique< MappedEngine<HEIGHT, WIDTH> >(mapped_board_path());
+    if (!engine->is_open()) {
+        return nullptr;
+    }
+    return engine;
+}
+
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_adaptive_engine() {
+    auto engine = std::make_unique< AdaptiveEngine<HEIGHT, WIDTH> >();
+    engine->set_log(false);
+    engine->set_sample_every(8);
+    return engine;
+}
+
+// Life as a two-state Generations rule, to compare the byte-per-cell table
+// kernel with the other engines, and Brian's Brain on the same kernel.
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_generations_engine() {
+    return std::make_unique< GenerationsEngine<HEIGHT, WIDTH> >();
+}
+
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_brians_brain_engine() {
+    auto engine = std::make_unique< GenerationsEngine<HEIGHT, WIDTH> >();
+    engine->set_rule("B2/S/C3");
+    return engine;
+}
+
+// Bosco's rule, range 5; the cost per cell should not depend on the range.
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_bosco_engine() {
+    auto engine = std::make_unique< LargerThanLifeEngine<HEIGHT, WIDTH> >();
+    engine->set_rule("R5,C0,M1,S34..58,B34..45,NM");
+    return engine;
+}
+
+// Lenia with Orbium's kernel and growth, one thread like the other engines.
+// Live cells load as the lowest nonzero value, which is enough for timing:
+// the FFT costs the same whatever the board holds.
+template <int HEIGHT, int WIDTH>
+std::unique_ptr< StepEngine<HEIGHT, WIDTH> > make_lenia_engine() {
+    return std::make_unique< LeniaEngine<HEIGHT, WIDTH> >(1);
+}
+
+template <int HEIGHT, int WIDTH>
+std::vector< BenchEngine<HEIGHT, WIDTH> > bench_engines() {
+    return {
+        { "life_game_judge",          make_judge_engine<HEIGHT, WIDTH>,          true  },
+        { "life_game_judge+counters", make_counted_judge_engine<HEIGHT, WIDTH>,  true  },
+        { "sparse_list",              make_sparse_engine<HEIGHT, WIDTH>,         true  },
+        { "bitwise",                  make_bitwise_engine<HEIGHT, WIDTH>,        true  },
+        { "banded",                   make_banded_engine<HEIGHT, WIDTH>,         true  },
+        { "block_lookup",             make_block_lookup_engine<HEIGHT, WIDTH>,   true  },
+        { "tiled",                    make_tiled_engine<HEIGHT, WIDTH>,          true  },
+        { "tiled(depth 8)",           make_temporal_tiled_engine<HEIGHT, WIDTH>, true  },
+        { "tiled+cache",              make_cached_tiled_engine<HEIGHT, WIDTH>,   true  },
+        { "mapped",                   make_mapped_engine<HEIGHT, WIDTH>,         true  },
+        { "adaptive",                 make_adaptive_engine<HEIGHT, WIDTH>,       true  },
+        { "generations(B3/S23)",      make_generations_engine<HEIGHT, WIDTH>,    true  },
+        { "generations(B2/S/C3)",     make_brians_brain_engine<HEIGHT, WIDTH>,   false },
+        { "larger_than_life(bosco)",  make_bosco_engine<HEIGHT, WIDTH>,          false },
+        { "lenia(orbium)",            make_lenia_engine<HEIGHT, WIDTH>,          false },
+    };
+}
+
+template <int HEIGHT, int WIDTH>
+void fill_field(BenchField<HEIGHT, WIDTH>& field, const LifePatterns::Cells& cells) {
+    for (auto& row : field) {
+        row.fill(0);
+    }
+    for (const auto& cell : cells) {
+        if (0 <= cell.first && cell.first < HEIGHT && 0 <= cell.second && cell.second < WIDTH) {
+            field[cell.first][cell.second] = 1;
+        }
+    }
+}
+
+// Whether `engine`'s board and the counters of its last run match the
+// reference's, checking only the counters the engine reports.
+template <int HEIGHT, int WIDTH>
+bool same_result(const BenchField<HEIGHT, WIDTH>& board, const GenerationCounters& counters,
+                 const BenchField<HEIGHT, WIDTH>& expected_board, const GenerationCounters& expected) {
+    return board == expected_board &&
+           (counters.population < 0 || counters.population == expected.population) &&
+           (counters.births < 0 || counters.births == expected.births) &&
+           (counters.deaths < 0 || counters.deaths == expected.deaths);
+}
+
+// Returns the number of engine and workload pairs that got Life wrong.
+template <int HEIGHT, int WIDTH>
+int32_t bench_size(const BenchOptions& options, std::vector<BenchResult>& results) {
+    using Field = BenchField<HEIGHT, WIDTH>;
+    using Clock = std::chrono::steady_clock;
+
+    // Boards of the larger sizes do not fit on the stack.
+    std::unique_ptr<Field> start = std::make_unique<Field>();
+    std::unique_ptr<Field> expected_board = std::make_unique<Field>();
+    std::unique_ptr<Field> board = std::make_unique<Field>();
+
+    const int64_t cells = static_cast<int64_t>(HEIGHT) * WIDTH;
+    const int32_t generations = static_cast<int32_t>(std::max<int64_t>(1, options.budget / cells));
+    int32_t mismatches = 0;
+
+    for (const BenchWorkload& workload : workloads) {
+        // The judge kernel through the same warmup and timed generations.
+        GenerationCounters expected, expected_hashed;
+        {
+            auto reference = make_counted_judge_engine<HEIGHT, WIDTH>();
+            fill_field<HEIGHT, WIDTH>(*start, workload.make(HEIGHT, WIDTH));
+            reference->load(*start);
+            reference->make_step(options.warmup, expected);
+            reference->make_step(generations, expected);
+            reference->store(*expected_board);
+            reference->set_hashing(true);
+            reference->make_step(HASH_CHECK_GENERATIONS, expected_hashed);
+        }
+
+        for (const BenchEngine<HEIGHT, WIDTH>& entry : bench_engines<HEIGHT, WIDTH>()) {
+            std::unique_ptr< StepEngine<HEIGHT, WIDTH> > engine = entry.make();
+            if (engine == nullptr) {
+                printf("%-24s %-12s %5dx%-5d skipped\n", entry.name, workload.name, HEIGHT, WIDTH);
+                continue;
+            }
+            GenerationCounters counters;
+            fill_field<HEIGHT, WIDTH>(*start, workload.make(HEIGHT, WIDTH));
+            engine->load(*start);
+            for (int32_t i = 0; i < options.warmup; i++) {
+                engine->step(counters);
+            }
+            engine->store(*start);
+
+            std::vector<double> samples;
+            for (int32_t rep = 0; rep < options.reps; rep++) {
+                engine->load(*start);
+                Clock::time_point begin = Clock::now();
+                engine->make_step(generations, counters);
+                std::chrono::duration<double> elapsed = Clock::now() - begin;
+                samples.push_back(elapsed.count() / generations);
+            }
+
+            BenchResult result;
+            result.engine      = entry.name;
+            result.workload    = workload.name;
+            result.height      = HEIGHT;
+            result.width       = WIDTH;
+            result.generations = generations;
+            result.reps        = options.reps;
+            result.min_sec     = *std::min_element(samples.begin(), samples.end());
+            result.max_sec     = *std::max_element(samples.begin(), samples.end());
+            double sum = 0, sum_sq = 0;
+            for (double sample : samples) {
+                sum += sample;
+                sum_sq += sample * sample;
+            }
+            result.mean_sec    = sum / samples.size();
+            result.stddev_sec  = std::sqrt(std::max(0.0, sum_sq / samples.size() - result.mean_sec * result.mean_sec));
+            result.population  = engine->get_population();
+            result.cache_hits  = counters.cache_hits;
+            result.cache_misses = counters.cache_misses;
+
+            printf("%-24s %-12s %5dx%-5d %12.1f gen/s %10.3e cells/s %8.3f ns/cell (+-%4.1f%%) pop %lld\n",
+                   result.engine.c_str(), result.workload.c_str(), HEIGHT, WIDTH,
+                   1.0 / result.mean_sec, cells / result.mean_sec, result.mean_sec * 1e9 / cells,
+                   100.0 * result.stddev_sec / result.mean_sec, static_cast<long long>(result.population));
+            // Whether first touch put the banded engine's pages where its workers run.
+            if (auto* banded = dynamic_cast< BandedEngine<HEIGHT, WIDTH>* >(engine.get())) {
+                NumaPlacement placement = banded->get_placement();
+                result.node_pages = placement.node_pages;
+                result.unplaced_pages = placement.unplaced;
+                printf("%-24s pages per node:", "");
+                for (size_t node = 0; node < placement.node_pages.size(); node++) {
+                    printf(" %zu:%lld", node, static_cast<long long>(placement.node_pages[node]));
+                }
+                printf(" unplaced:%lld\n", static_cast<long long>(placement.unplaced));
+            }
+            if (result.cache_hits + result.cache_misses > 0) {
+                printf("%-24s tile cache hit rate %5.1f%% (%lld hits, %lld misses)\n", "",
+                       100.0 * result.cache_hits / (result.cache_hits + result.cache_misses),
+                       static_cast<long long>(result.cache_hits), static_cast<long long>(result.cache_misses));
+            }
+            if (entry.life) {
+                engine->store(*board);
+                bool same = same_result<HEIGHT, WIDTH>(*board, counters, *expected_board, expected);
+                GenerationCounters hashed;
+                engine->set_hashing(true);
+                engine->make_step(HASH_CHECK_GENERATIONS, hashed);
+                same = same && hashed.hash_delta == expected_hashed.hash_delta;
+                if (!same) {
+                    fprintf(stderr, "MISMATCH %s on %s %dx%d: pop %lld births %lld deaths %lld hash %016llx, "
+                                    "expected pop %lld births %lld deaths %lld hash %016llx\n",
+                            entry.name, workload.name, HEIGHT, WIDTH, static_cast<long long>(counters.population),
+                            static_cast<long long>(counters.births), static_cast<long long>(counters.deaths),
+                            static_cast<unsigned long long>(hashed.hash_delta),
+                            static_cast<long long>(expected.population), static_cast<long long>(expected.births),
+                            static_cast<long long>(expected.deaths),
+                            static_cast<unsigned long long>(expected_hashed.hash_delta));
+                    mismatches++;
+                }
+            }
+            fflush(stdout);
+            results.push_back(result);
+        }
+    }
+    // Every engine is gone by now, so the mapped board is no longer open.
+    std::remove(mapped_board_path().c_str());
+    return mismatches;
+}
+
+// All 64 universes of MultiUniverse on 50% soups, timed per board so the
+// figures line up with the single-board engines. Every universe of the last
+// repetition is checked against the judge kernel; returns how many differ.
+template <int HEIGHT, int WIDTH>
+int32_t bench_multi_universe(const BenchOptions& options, std::vector<BenchResult>& results) {
+    using Clock = std::chrono::steady_clock;
+    using Universes = MultiUniverse<HEIGHT, WIDTH>;
+
+    const int64_t cells = static_cast<int64_t>(HEIGHT) * WIDTH;
+    const int64_t boards = Universes::UNIVERSES;
+    const int32_t generations = static_cast<int32_t>(std::max<int64_t>(1, options.budget / (cells * boards)));
+
+    std::unique_ptr<Universes> universes = std::make_unique<Universes>();
+    std::vector< BenchField<HEIGHT, WIDTH> > timed_from(boards);
+    std::vector<double> samples;
+    for (int32_t rep = 0; rep < options.reps; rep++) {
+        universes->fill_random(0.5, 20240601);
+        for (int32_t i = 0; i < options.warmup; i++) {
+            universes->step();
+        }
+        if (rep == options.reps - 1) {
+            for (int32_t u = 0; u < boards; u++) {
+                universes->store(u, timed_from[u]);
+            }
+        }
+        Clock::time_point begin = Clock::now();
+        for (int32_t i = 0; i < generations; i++) {
+            universes->step();
+        }
+        std::chrono::duration<double> elapsed = Clock::now() - begin;
+        samples.push_back(elapsed.count() / generations / boards);
+    }
+
+    BenchResult result;
+    result.engine      = "multi_universe";
+    result.workload    = "soup50";
+    result.height      = HEIGHT;
+    result.width       = WIDTH;
+    result.generations = generations;
+    result.reps        = options.reps;
+    result.min_sec     = *std::min_element(samples.begin(), samples.end());
+    result.max_sec     = *std::max_element(samples.begin(), samples.end());
+    double sum = 0, sum_sq = 0;
+    for (double sample : samples) {
+        sum += sample;
+        sum_sq += sample * sample;
+    }
+    result.mean_sec    = sum / samples.size();
+    result.stddev_sec  = std::sqrt(std::max(0.0, sum_sq / samples.size() - result.mean_sec * result.mean_sec));
+    result.population  = universes->populations()[0];
+
+    printf("%-24s %-12s %5dx%-5d %12.1f gen/s %10.3e cells/s %8.3f ns/cell (+-%4.1f%%) pop %lld (x%lld boards)\n",
+           result.engine.c_str(), result.workload.c_str(), HEIGHT, WIDTH,
+           1.0 / result.mean_sec, cells / result.mean_sec, result.mean_sec * 1e9 / cells,
+           100.0 * result.stddev_sec / result.mean_sec, static_cast<long long>(result.population),
+           static_cast<long long>(boards));
+    fflush(stdout);
+    results.push_back(result);
+
+    int32_t mismatches = 0;
+    const std::array<int64_t, Universes::UNIVERSES> populations = universes->populations();
+    auto reference = make_counted_judge_engine<HEIGHT, WIDTH>();
+    auto expected_board = std::make_unique< BenchField<HEIGHT, WIDTH> >();
+    auto board = std::make_unique< BenchField<HEIGHT, WIDTH> >();
+    for (int32_t u = 0; u < boards; u++) {
+        GenerationCounters expected;
+        reference->load(timed_from[u]);
+        reference->make_step(generations, expected);
+        reference->store(*expected_board);
+        universes->store(u, *board);
+        if (*board != *expected_board || populations[u] != expected.population) {
+            fprintf(stderr, "MISMATCH multi_universe %dx%d universe %d: pop %lld, expected %lld\n",
+                    HEIGHT, WIDTH, u, static_cast<long long>(populations[u]),
+                    static_cast<long long>(expected.population));
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+void write_json(const char* file_name, const BenchOptions& options, const std::vector<BenchResult>& results) {
+    std::ofstream out(file_name);
+    out << "{\n  \"warmup\": " << options.warmup << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        const double cells = static_cast<double>(r.height) * r.width;
+        out << "    {\"engine\": \"" << r.engine << "\", \"workload\": \"" << r.workload << "\""
+            << ", \"height\": " << r.height << ", \"width\": " << r.width
+            << ", \"generations\": " << r.generations << ", \"reps\": " << r.reps
+            << ", \"sec_per_gen_mean\": " << r.mean_sec << ", \"sec_per_gen_min\": " << r.min_sec
+            << ", \"sec_per_gen_max\": " << r.max_sec << ", \"sec_per_gen_stddev\": " << r.stddev_sec
+            << ", \"gens_per_sec\": " << 1.0 / r.mean_sec
+            << ", \"cells_per_sec\": " << cells / r.mean_sec
+            << ", \"ns_per_cell\": " << r.mean_sec * 1e9 / cells
+            << ", \"population\": " << r.population;
+        if (r.engine == "banded") {
+            out << ", \"node_pages\": [";
+            for (size_t node = 0; node < r.node_pages.size(); node++) {
+                out << (node != 0 ? ", " : "") << r.node_pages[node];
+            }
+            out << "], \"unplaced_pages\": " << r.unplaced_pages;
+        }
+        if (r.cache_hits + r.cache_misses > 0) {
+            out << ", \"cache_hits\": " << r.cache_hits << ", \"cache_misses\": " << r.cache_misses
+                << ", \"cache_hit_rate\": " << static_cast<double>(r.cache_hits) / (r.cache_hits + r.cache_misses);
+        }
+        out << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--json")) {
+            options.json = argv[i + 1];
+        } else if (!strcmp(argv[i], "--reps")) {
+            options.reps = std::max(1, atoi(argv[i + 1]));
+        } else if (!strcmp(argv[i], "--warmup")) {
+            options.warmup = std::max(0, atoi(argv[i + 1]));
+        } else if (!strcmp(argv[i], "--budget")) {
+            options.budget = std::max(1LL, atoll(argv[i + 1]));
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    int32_t mismatches = 0;
+    mismatches += bench_size<64, 64>(options, results);
+    mismatches += bench_multi_universe<64, 64>(options, results);
+    mismatches += bench_multi_universe<32, 32>(options, results);
+    mismatches += bench_size<256, 256>(options, results);
+    mismatches += bench_size<1024, 1024>(options, results);
+
+    if (options.json != nullptr) {
+        write_json(options.json, options, results);
+    }
+    if (mismatches != 0) {
+        fprintf(stderr, "%d results differ from the judge kernel\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
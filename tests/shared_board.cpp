@@ -0,0 +1,130 @@
+#include <bitwise_engine.h>
+#include <life_patterns.h>
+#include <shared_board.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Multi-process run on one host: the board sits in a shared-memory segment,
+// copies of this program attach to it as workers, and this process drives
+// the generations, reads the board through a read-only attachment as a
+// viewer would and checks it and the counters against a BitwiseEngine.
+//
+//   shared_board [--workers N] [--generations N] [--chunk N]
+//   shared_board --worker NAME INDEX
+
+#ifdef __linux__
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+
+static constexpr int BOARD_HEIGHT = 1024;
+static constexpr int BOARD_WIDTH = 1024;
+
+using Board = SharedBoard<BOARD_HEIGHT, BOARD_WIDTH>;
+
+int main(int argc, char** argv) {
+    if (argc == 4 && !strcmp(argv[1], "--worker")) {
+        auto board = std::make_unique<Board>();
+        if (!board->attach(argv[2], true)) {
+            fprintf(stderr, "worker: cannot attach to %s\n", argv[2]);
+            return 1;
+        }
+        board->run_worker(atoi(argv[3]));
+        return 0;
+    }
+
+    int32_t workers = 4;
+    int32_t generations = 1000;
+    int32_t chunk = 100;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--workers")) {
+            workers = std::max(1, std::min(Board::MAX_WORKERS, atoi(argv[i + 1])));
+        } else if (!strcmp(argv[i], "--generations")) {
+            generations = std::max(1, atoi(argv[i + 1]));
+        } else if (!strcmp(argv[i], "--chunk")) {
+            chunk = std::max(1, atoi(argv[i + 1]));
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    const std::string name = "/lifegame_" + std::to_string(getpid());
+    auto board = std::make_unique<Board>();
+    if (!board->create(name, workers, true)) {
+        fprintf(stderr, "cannot create %s\n", name.c_str());
+        return 1;
+    }
+    auto reference = std::make_unique< BitwiseEngine<BOARD_HEIGHT, BOARD_WIDTH> >();
+    reference->set_hashing(true);
+    for (const auto& cell : LifePatterns::random_soup(BOARD_HEIGHT, BOARD_WIDTH, 0.35, 20240601)) {
+        reference->set_id(cell.first, cell.second, 1);
+    }
+    board->load(reference->get_grid());
+
+    std::vector<pid_t> processes(workers);
+    for (int32_t i = 0; i < workers; i++) {
+        std::string worker_flag = "--worker", segment = name, index = std::to_string(i);
+        char* worker_argv[] = { argv[0], &worker_flag[0], &segment[0], &index[0], nullptr };
+        if (posix_spawn(&processes[i], argv[0], nullptr, nullptr, worker_argv, environ) != 0) {
+            fprintf(stderr, "cannot start worker %d\n", i);
+            Board::remove(name);
+            return 1;
+        }
+    }
+
+    auto viewer = std::make_unique<Board>();
+    if (!viewer->attach(name, false)) {
+        fprintf(stderr, "cannot attach a viewer\n");
+    }
+
+    bool matches = true;
+    double seconds = 0;
+    for (int32_t done = 0; done < generations; done += chunk) {
+        int32_t k = std::min(chunk, generations - done);
+        GenerationCounters shared, local;
+        auto start = std::chrono::steady_clock::now();
+        board->step(k, shared);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        reference->make_step(k, local);
+
+        bool same = shared.population == local.population && shared.births == local.births &&
+                    shared.deaths == local.deaths && shared.hash_delta == local.hash_delta;
+        if (viewer->is_open()) {
+            const uint32_t generation = viewer->get_generation();
+            for (int32_t x = 0; x < BOARD_HEIGHT && same; x++) {
+                same = std::equal(viewer->row(generation, x), viewer->row(generation, x) + Board::WORDS,
+                                  reference->get_grid().row(x));
+            }
+        }
+        matches = matches && same;
+        printf("generation %6d  population %8lld  births %8lld  deaths %8lld  %s\n", done + k,
+               static_cast<long long>(shared.population), static_cast<long long>(shared.births),
+               static_cast<long long>(shared.deaths), same ? "ok" : "MISMATCH");
+    }
+    board->stop();
+    for (pid_t process : processes) {
+        waitpid(process, nullptr, 0);
+    }
+    Board::remove(name);
+
+    double cells = static_cast<double>(BOARD_HEIGHT) * BOARD_WIDTH * generations;
+    printf("%d workers, %d generations of %dx%d in %.3f s: %.3f ns/cell\n", workers, generations, BOARD_HEIGHT,
+           BOARD_WIDTH, seconds, seconds * 1e9 / cells);
+    printf("%s\n", matches ? "matches the local run" : "DIFFERS from the local run");
+    return matches ? 0 : 1;
+}
+#else
+int main() {
+    fprintf(stderr, "shared_board needs Linux futexes\n");
+    return 1;
+}
+#endif
@@ -0,0 +1,166 @@
+#include <bitwise_engine.h>
+#include <life_patterns.h>
+#include <slab_network.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+// Distributed run on localhost: the coordinator starts copies of this program
+// as workers, splits a soup between them, steps it and checks the gathered
+// board and the counters against a BitwiseEngine run in this process.
+//
+//   slab_network [--workers N] [--generations N] [--chunk N]
+//   slab_network --worker HOST PORT
+
+static constexpr int BOARD_HEIGHT = 1024;
+static constexpr int BOARD_WIDTH = 1024;
+
+using Coordinator = SlabCoordinator<BOARD_HEIGHT, BOARD_WIDTH>;
+using Worker = SlabWorker<BOARD_HEIGHT, BOARD_WIDTH>;
+
+#ifdef _WIN32
+using Process = HANDLE;
+#else
+using Process = pid_t;
+#endif
+
+// Starts `program --worker 127.0.0.1 port`.
+static bool launch_worker(const char* program, unsigned short port, Process& process) {
+    std::string port_text = std::to_string(port);
+#ifdef _WIN32
+    std::string command = std::string("\"") + program + "\" --worker 127.0.0.1 " + port_text;
+    STARTUPINFOA startup;
+    PROCESS_INFORMATION info;
+    ZeroMemory(&startup, sizeof(startup));
+    startup.cb = sizeof(startup);
+    if (!CreateProcessA(nullptr, &command[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &info)) {
+        return false;
+    }
+    CloseHandle(info.hThread);
+    process = info.hProcess;
+    return true;
+#else
+    std::string worker_flag = "--worker", host = "127.0.0.1";
+    char* argv[] = { const_cast<char*>(program), &worker_flag[0], &host[0], &port_text[0], nullptr };
+    return posix_spawn(&process, program, nullptr, nullptr, argv, environ) == 0;
+#endif
+}
+
+static void wait_worker(Process process) {
+#ifdef _WIN32
+    WaitForSingleObject(process, INFINITE);
+    CloseHandle(process);
+#else
+    waitpid(process, nullptr, 0);
+#endif
+}
+
+int main(int argc, char** argv) {
+    if (argc == 4 && !strcmp(argv[1], "--worker")) {
+        Worker worker;
+        if (!worker.connect(sf::IpAddress(argv[2]), static_cast<unsigned short>(atoi(argv[3]))) || !worker.run()) {
+            fprintf(stderr, "worker: lost the coordinator or a neighbour\n");
+            return 1;
+        }
+        return 0;
+    }
+
+    int32_t workers = 4;
+    int32_t generations = 1000;
+    int32_t chunk = 100;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--workers")) {
+            workers = std::max(1, std::min(BOARD_HEIGHT, atoi(argv[i + 1])));
+        } else if (!strcmp(argv[i], "--generations")) {
+            generations = std::max(1, atoi(argv[i + 1]));
+        } else if (!strcmp(argv[i], "--chunk")) {
+            chunk = std::max(1, atoi(argv[i + 1]));
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    Coordinator coordinator;
+    coordinator.set_hashing(true);
+    if (!coordinator.listen()) {
+        fprintf(stderr, "cannot listen\n");
+        return 1;
+    }
+    std::vector<Process> processes(workers);
+    for (int32_t i = 0; i < workers; i++) {
+        if (!launch_worker(argv[0], coordinator.get_port(), processes[i])) {
+            fprintf(stderr, "cannot start worker %d\n", i);
+            return 1;
+        }
+    }
+    if (!coordinator.accept_workers(workers)) {
+        fprintf(stderr, "workers did not all connect\n");
+        return 1;
+    }
+
+    auto reference = std::make_unique< BitwiseEngine<BOARD_HEIGHT, BOARD_WIDTH> >();
+    reference->set_hashing(true);
+    for (const auto& cell : LifePatterns::random_soup(BOARD_HEIGHT, BOARD_WIDTH, 0.35, 20240601)) {
+        reference->set_id(cell.first, cell.second, 1);
+    }
+    if (!coordinator.load(reference->get_grid())) {
+        fprintf(stderr, "cannot load the board\n");
+        return 1;
+    }
+
+    bool matches = true;
+    double seconds = 0;
+    auto snapshot = std::make_unique<Coordinator::Grid>();
+    for (int32_t done = 0; done < generations; done += chunk) {
+        int32_t k = std::min(chunk, generations - done);
+        GenerationCounters distributed, local;
+        auto start = std::chrono::steady_clock::now();
+        if (!coordinator.step(k, distributed)) {
+            fprintf(stderr, "step failed\n");
+            return 1;
+        }
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        reference->make_step(k, local);
+        if (!coordinator.gather(*snapshot)) {
+            fprintf(stderr, "gather failed\n");
+            return 1;
+        }
+        bool same = *snapshot == reference->get_grid() && distributed.population == local.population &&
+                    distributed.births == local.births && distributed.deaths == local.deaths &&
+                    distributed.hash_delta == local.hash_delta;
+        matches = matches && same;
+        printf("generation %6d  population %8lld  births %8lld  deaths %8lld  %s\n", done + k,
+               static_cast<long long>(distributed.population), static_cast<long long>(distributed.births),
+               static_cast<long long>(distributed.deaths), same ? "ok" : "MISMATCH");
+    }
+    coordinator.quit();
+    for (Process process : processes) {
+        wait_worker(process);
+    }
+
+    double cells = static_cast<double>(BOARD_HEIGHT) * BOARD_WIDTH * generations;
+    printf("%d workers, %d generations of %dx%d in %.3f s: %.3f ns/cell\n", workers, generations, BOARD_HEIGHT,
+           BOARD_WIDTH, seconds, seconds * 1e9 / cells);
+    printf("%s\n", matches ? "matches the local run" : "DIFFERS from the local run");
+    return matches ? 0 : 1;
+}
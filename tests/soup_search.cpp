@@ -0,0 +1,56 @@
+#include <soup_search.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Soup search: runs random 16x16 soups to the end on a 128x128 board, takes
+// a census of what is left and prints the commonest objects and the rate.
+//
+//   soup_search [--prefix ID] [--soups N] [--threads N] [--top N]
+
+int main(int argc, char** argv) {
+    std::string prefix = "soup_";
+    uint64_t soups = 10000;
+    size_t threads = 0;
+    int32_t top = 30;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--prefix")) {
+            prefix = argv[i + 1];
+        } else if (!strcmp(argv[i], "--soups")) {
+            soups = std::max(1LL, atoll(argv[i + 1]));
+        } else if (!strcmp(argv[i], "--threads")) {
+            threads = std::max(0, atoi(argv[i + 1]));
+        } else if (!strcmp(argv[i], "--top")) {
+            top = std::max(0, atoi(argv[i + 1]));
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    SoupSearch<128, 128> search(threads);
+    SoupSearch<128, 128>::Report report = search.search(prefix, soups);
+
+    std::vector< std::pair<uint64_t, std::string> > objects;
+    uint64_t total = 0;
+    for (const auto& entry : report.census) {
+        objects.emplace_back(entry.second, entry.first);
+        total += entry.second;
+    }
+    std::sort(objects.begin(), objects.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    for (int32_t i = 0; i < top && i < static_cast<int32_t>(objects.size()); i++) {
+        printf("%12llu  %s\n", static_cast<unsigned long long>(objects[i].first), objects[i].second.c_str());
+    }
+    printf("%llu objects of %zu kinds, %llu soups unsettled\n", static_cast<unsigned long long>(total),
+           objects.size(), static_cast<unsigned long long>(report.unsettled));
+    printf("%llu soups in %.3f s on %zu threads: %.1f soups/s\n", static_cast<unsigned long long>(report.soups),
+           report.seconds, search.threads(), report.soups_per_second());
+    return 0;
+}